@@ -2,6 +2,7 @@
 #include "ImGuiSystem.h"
 #include "LogSystem.h"
 #include "Utils.h"
+#include "ThreadPool.h"
 
 #include "VkRenderer/Swapchain.h"
 #include "VkRenderer/Texture.h"
@@ -9,6 +10,12 @@
 #include "Core.h"
 
 #include "VkRenderer/Context.h"
+#include "VkRenderer/UploadBatcher.h"
+#include "VkRenderer/GpuTimeline.h"
+#include "VkRenderer/DeletionQueue.h"
+#include "VkRenderer/ShaderLibrary.h"
+#include "VkRenderer/DescriptorAllocator.h"
+#include "VkRenderer/BindlessRegistry.h"
 
 #include "Scene/Camera.h"
 #include "Scene/Light.h"
@@ -57,11 +64,20 @@ int main(int, char**)
 	GLFWWindowSystem		glfwWindow;
 	ImGuiSystem				imGui;
 	GLFWWindowData*			windowData	= glfwWindow.CreateWindow();
+	ez::ThreadPool			threadPool;
 
 	Context context;
 	Device device;
 	LogicalDevice logicalDevice(device);
+	MemoryAllocator memoryAllocator;
+	ShaderLibrary shaderLibrary;
+	DescriptorAllocator descriptorAllocator;
+	BindlessRegistry bindlessRegistry;
 	Surface surface(windowData);
+	GpuTimeline gpuTimeline;
+	DeletionQueue deletionQueue;
+	UniformRing uniformRing(1 << 20);
+	UploadBatcher uploadBatcher;
 	Swapchain swapchain(surface, windowData);
 
 	imGui.Init(windowData, context, device, logicalDevice, swapchain);
@@ -77,71 +93,105 @@ int main(int, char**)
 	AssetsMgr<Mesh> meshMgr;
 
 	LoadAssets();
+	uploadBatcher.Submit();
+
+	// Layouts are reflected from the shaders, only the scopes and the buffers bound with an offset are declared
+	const BindingsSet kGlobalSet{ BindingsSet::Scope::GLOBAL, { { 0, Bindings::Type::DYNAMIC_BUFFER } } };
+
+	// Pipelines compile on the thread pool, the fallback is drawn until they are ready
+
+	AssetsMgr<Material>::load("fallback", viewport,
+		"D:/Personal project/DemoEngine/shaders/bin/gizmo.vert.spv",
+		"D:/Personal project/DemoEngine/shaders/bin/gizmo.frag.spv",
+		std::vector<BindingsSet>{ kGlobalSet }, VK_CULL_MODE_BACK_BIT, false, Vertex::Format::COMPACT);
 
 	AssetsMgr<Material>::load("skyboxMaterial", viewport,
 		"D:/Personal project/DemoEngine/shaders/bin/skybox.vert.spv",
 		"D:/Personal project/DemoEngine/shaders/bin/skybox.frag.spv",
-		std::vector<BindingsSet>{ { BindingsSet::Scope::GLOBAL, { { 0, Bindings::Stage::VERTEX, Bindings::Type::BUFFER, 1 }, { 1, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 } }} },
-		VK_CULL_MODE_FRONT_BIT, Vertex::POSITION);
+		std::vector<BindingsSet>{ kGlobalSet }, VK_CULL_MODE_FRONT_BIT, false, Vertex::Format::COMPACT);
 
 	AssetsMgr<Material>::load("mat", viewport,
-		"D:/Personal project/DemoEngine/shaders/bin/shader.vert.spv",
+		"D:/Personal project/DemoEngine/shaders/bin/shader_compact.vert.spv",
 		"D:/Personal project/DemoEngine/shaders/bin/shader.frag.spv",
-		std::vector<BindingsSet>{ { BindingsSet::Scope::GLOBAL, { { 0, Bindings::Stage::VERTEX, Bindings::Type::BUFFER, 1 }, { 1, Bindings::Stage::FRAGMENT, Bindings::Type::BUFFER, 1 },
-			{ 2, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 }, { 3, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 },
-			{ 4, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 } }},
-		{ BindingsSet::Scope::MATERIAL, {{ 0, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 }, { 1, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 },
-			{ 2, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 }, { 3, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 },
-			{ 4, Bindings::Stage::FRAGMENT, Bindings::Type::SAMPLER, 1 }} },
-		{ BindingsSet::Scope::ACTOR, {{ 0, Bindings::Stage::VERTEX, Bindings::Type::BUFFER, 1 }} }
-		});
+		std::vector<BindingsSet>{ kGlobalSet, { BindingsSet::Scope::MATERIAL, {} } }, VK_CULL_MODE_BACK_BIT, false, Vertex::Format::COMPACT);
+
+	// With descriptor indexing the PBR instances share all their sets, they only differ by the MaterialData index they push
+	const bool kBindless = logicalDevice._descriptorIndexing;
+	if (kBindless)
+	{
+		AssetsMgr<Material>::load("matBindless", viewport,
+			"D:/Personal project/DemoEngine/shaders/bin/shader_compact.vert.spv",
+			"D:/Personal project/DemoEngine/shaders/bin/shader_bindless.frag.spv",
+			std::vector<BindingsSet>{ kGlobalSet, { BindingsSet::Scope::BINDLESS, {} } }, VK_CULL_MODE_BACK_BIT, false, Vertex::Format::COMPACT);
+	}
 
 	AssetsMgr<Material>::load("grid", viewport,
 		"D:/Personal project/DemoEngine/shaders/bin/grid.vert.spv",
 		"D:/Personal project/DemoEngine/shaders/bin/grid.frag.spv",
-		std::vector<BindingsSet>{ { BindingsSet::Scope::GLOBAL, { { 0, Bindings::Stage::VERTEX, Bindings::Type::BUFFER, 1 } }} }, VK_CULL_MODE_BACK_BIT, Vertex::POSITION);
+		std::vector<BindingsSet>{ kGlobalSet }, VK_CULL_MODE_BACK_BIT, false, Vertex::Format::COMPACT);
+	// The grid fades out with its alpha, it is blended over the opaque draws
+	AssetsMgr<Material>::get("grid")._transparent = true;
 	
 	AssetsMgr<Material>::load("gizmo", viewport,
 		"D:/Personal project/DemoEngine/shaders/bin/gizmo.vert.spv",
 		"D:/Personal project/DemoEngine/shaders/bin/gizmo.frag.spv",
-		std::vector<BindingsSet>{ { BindingsSet::Scope::GLOBAL, { { 0, Bindings::Stage::VERTEX, Bindings::Type::BUFFER, 1 } }}, 
-		{ BindingsSet::Scope::ACTOR, {{ 0, Bindings::Stage::VERTEX, Bindings::Type::BUFFER, 1 }, { 1, Bindings::Stage::FRAGMENT, Bindings::Type::BUFFER, 1 }} } }, VK_CULL_MODE_BACK_BIT, Vertex::POSITION, true);
+		std::vector<BindingsSet>{ kGlobalSet }, VK_CULL_MODE_BACK_BIT, true, Vertex::Format::COMPACT);
 
-	MaterialInstance gridMat(AssetsMgr<Material>::get("grid"), { {&cam._ubo} });
+	AssetsMgr<Material>::get("fallback").Wait();
+	MaterialInstance fallbackMat(AssetsMgr<Material>::get("fallback"), { { &uniformRing._buffer } });
+	fallbackMat._parameters = { 0.5f, 0.5f, 0.5f, 1.f };
+
+	MaterialInstance gridMat(AssetsMgr<Material>::get("grid"), { {&uniformRing._buffer} });
 	Actor grid(AssetsMgr<Mesh>::get("plane"), gridMat);
 
-	MaterialInstance skyMaterialInstance(AssetsMgr<Material>::get("skyboxMaterial"), { { &cam._ubo, &AssetsMgr<Texture>::get("skyboxCubemap") } });
+	MaterialInstance skyMaterialInstance(AssetsMgr<Material>::get("skyboxMaterial"), { { &uniformRing._buffer, &AssetsMgr<Texture>::get("skyboxCubemap") } });
 	Actor skySphere(AssetsMgr<Mesh>::get("sphere"), skyMaterialInstance);
 
-	MaterialInstance matInstance1(AssetsMgr<Material>::get("mat"), 
-		{ { &cam._ubo, &light._ubo, &AssetsMgr<Texture>::get("skyboxCubemap"), &AssetsMgr<Texture>::get("skyboxIradianceCubemap"), &AssetsMgr<Texture>::get("brdf") },
+	// The transforms are pushed with the draws, actors of an instance share the same sets.
+	// The light is read from the UniformRing too, at an offset moving every frame
+	const std::vector<std::vector<void*>> kMatData = { { &uniformRing._buffer, &uniformRing._buffer, &AssetsMgr<Texture>::get("skyboxCubemap"), &AssetsMgr<Texture>::get("skyboxIradianceCubemap"), &AssetsMgr<Texture>::get("brdf") },
 		{ &AssetsMgr<Texture>::get("color"), &AssetsMgr<Texture>::get("metal"), &AssetsMgr<Texture>::get("normal"), &AssetsMgr<Texture>::get("rough"),
-		&AssetsMgr<Texture>::get("aO")} });
+		&AssetsMgr<Texture>::get("aO")} };
+	const std::vector<std::vector<void*>> kBindlessMatData = { { &uniformRing._buffer, &uniformRing._buffer } };
+	const std::array<const Texture*, BindlessRegistry::MATERIAL_TEXTURES> kBindlessTextures = { &AssetsMgr<Texture>::get("color"),
+		&AssetsMgr<Texture>::get("metal"), &AssetsMgr<Texture>::get("normal"), &AssetsMgr<Texture>::get("rough"), &AssetsMgr<Texture>::get("aO"),
+		&AssetsMgr<Texture>::get("skyboxCubemap"), &AssetsMgr<Texture>::get("skyboxIradianceCubemap"), &AssetsMgr<Texture>::get("brdf") };
 
-	MaterialInstance matInstance2(AssetsMgr<Material>::get("mat"),
-		{ { &cam._ubo, &light._ubo, &AssetsMgr<Texture>::get("skyboxCubemap"), &AssetsMgr<Texture>::get("skyboxIradianceCubemap"), &AssetsMgr<Texture>::get("brdf") },
-		{ &AssetsMgr<Texture>::get("color"), &AssetsMgr<Texture>::get("metal"), &AssetsMgr<Texture>::get("normal"), &AssetsMgr<Texture>::get("rough"),
-		&AssetsMgr<Texture>::get("aO")} });
+	const Material& kPbrMaterial = AssetsMgr<Material>::get(kBindless ? "matBindless" : "mat");
+	const std::vector<std::vector<void*>>& kPbrData = kBindless ? kBindlessMatData : kMatData;
 
-	Actor mesh(AssetsMgr<Mesh>::get("sphere"), matInstance1);
-	matInstance1.UpdateSet(2, { { &mesh._transform._buffer } });
+	MaterialInstance matInstance(kPbrMaterial, kPbrData, &fallbackMat);
 
-	Actor second(AssetsMgr<Mesh>::get("cube"), matInstance2);
-	matInstance2.UpdateSet(2, { { &second._transform._buffer } });
+	// Specialization constants of shader.frag, the cube runs a variant without normal map, roughness map nor IBL
+	enum PbrConstant : uint32_t
+	{
+		USE_NORMAL_MAP		= 0,
+		USE_ROUGHNESS_MAP	= 1,
+		CONSTANT_ROUGHNESS	= 2,
+		USE_IBL				= 3
+	};
+	MaterialInstance cheapMatInstance(kPbrMaterial, kPbrData, &fallbackMat,
+		Specialization().Set(USE_NORMAL_MAP, false).Set(USE_ROUGHNESS_MAP, false).Set(CONSTANT_ROUGHNESS, 0.6f).Set(USE_IBL, false));
+
+	if (kBindless)
+	{
+		matInstance.SetBindlessTextures(kBindlessTextures);
+		cheapMatInstance.SetBindlessTextures(kBindlessTextures);
+	}
 
-	MaterialInstance gizmoMat(AssetsMgr<Material>::get("gizmo"), { { &cam._ubo } });
+	Actor mesh(AssetsMgr<Mesh>::get("sphere"), matInstance);
+	Actor second(AssetsMgr<Mesh>::get("cube"), cheapMatInstance);
 
-	Buffer colorBuffer(sizeof(Vec3), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-	Vec3 col{ 1.0f, 0.f, 0.f };
-	colorBuffer.Map(&col, sizeof(Vec3));
+	MaterialInstance gizmoMat(AssetsMgr<Material>::get("gizmo"), { { &uniformRing._buffer } });
+	gizmoMat._parameters = { 1.f, 0.f, 0.f, 1.f };
 
 	Actor gizmo(AssetsMgr<Mesh>::get("cubeSq"), gizmoMat);
-	gizmoMat.UpdateSet(1, { { &gizmo._transform._buffer }, { &colorBuffer } });
 
 	second._transform.Translate({ 0.f, 0.f, 2.5f });
 	gizmo._transform.Translate({ 0.f, 3.f, 1.f });
 
 	Scene scene{};
+	scene._camera = &cam;
 	scene._viewports.emplace_back(&viewport);
 	scene._actors.emplace_back(&mesh);
 	scene._actors.emplace_back(&second);
@@ -163,6 +213,10 @@ int main(int, char**)
 		// Clear
 		imGui.StartFrame();
 
+		uploadBatcher.Update();
+		deletionQueue.Update();
+		descriptorAllocator.Update();
+
 		if (windowData->_shouldUpdate)
 		{
 			swapchain.Resize(surface, windowData);
@@ -198,15 +252,24 @@ int main(int, char**)
 		}
 		mousePos = windowData->_mousePos;
 		
+		uniformRing.BeginFrame();
 		cam.Update();
+		light.Update();
+
+		// The global set shows the light at its offset of this frame, a transient set is written instead of caching one per frame
+		const std::vector<uint32_t> kLightOffsets = { 0, light._uboOffset };
+		matInstance.UpdateTransientSet(0, kPbrData[0], kLightOffsets);
+		cheapMatInstance.UpdateTransientSet(0, kPbrData[0], kLightOffsets);
 
 		mesh._transform.Rotate(Quat(deltaTime * glm::radians(10.0f) * Vec3{ 0.f, 1.f, 0.f }));
 
 		// Draw
 		Draw(scene);
+		uniformRing.EndFrame();
 
 		ez::LogSystem::Draw();
 		ez::ProfileSystem::Draw();
+		DrawWindow("Memory", memoryAllocator, nullptr);
 
 		if(!swapchain.AcquireNextImage())
 		{
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace ez
+{
+	// Read-only view of a whole file mapped in memory
+	class MappedFile final
+	{
+		const void*	_data		= nullptr;
+		size_t		_size		= 0;
+
+#ifdef _WIN32
+		void*		_file		= nullptr;
+		void*		_mapping	= nullptr;
+#else
+		int			_file		= -1;
+#endif
+
+	public:
+		MappedFile() = default;
+		MappedFile(const std::string& kPath);
+		~MappedFile();
+
+		MappedFile(const MappedFile& kMappedFile) = delete;
+		MappedFile(MappedFile&& mappedFile);
+
+		MappedFile& operator=(const MappedFile& kMappedFile) = delete;
+		MappedFile& operator=(MappedFile&& mappedFile);
+
+	private:
+		void Clean();
+
+	public:
+		bool		IsOpen() const;
+		const void*	Data() const;
+		size_t		Size() const;
+	};
+}
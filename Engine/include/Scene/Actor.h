@@ -2,6 +2,7 @@
 
 #include "Transform.h"
 #include "Mesh.h"
+#include "Camera.h"
 #include "VkRenderer/Material.h"
 
 class Actor
@@ -17,6 +18,17 @@ public:
 	Actor(const Mesh& kMesh, const MaterialInstance& kMaterial);
 
 public:
-	void Draw(const CommandBuffer& commandBuffer) const;
+	const Mesh& GetMesh() const;
+	// The material instance, its fallback while it builds, nullptr if none is ready
+	const MaterialInstance* GetDrawable() const;
+
+	// From the camera to the center of the bounds
+	float GetDistance(const Camera& kCamera) const;
+	// LOD of the mesh for its size on screen, kViewportHeight in pixels
+	size_t SelectLod(const Camera& kCamera, const float kViewportHeight) const;
+
+	// Pushes the transform and the parameters of the material in the DrawConstants.
+	// Draws the fallback of the material while it builds, nothing without one
+	void Draw(CommandRecorder& recorder, const DynamicOffsets& kDynamicOffsets = {}, const size_t kLod = 0) const;
 
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "VkRenderer/Buffer.h"
+#include "VkRenderer/UniformRing.h"
 
 #include "Wrappers/glm.h"
 
@@ -16,11 +16,14 @@ public:
 	float _near = 0.1f;
 	float _far	= 512.f;
 
-	Buffer _ubo;
+	// view, proj and pos, rewritten in the UniformRing every frame
+	static constexpr uint32_t UBO_SIZE = sizeof(Mat4) * 2 + sizeof(Vec3);
+
+	uint32_t _uboOffset = 0;
 
 public:
 	Camera(const float fov, const float near, const float far);
 
 public:
-	void Update() const;
+	void Update();
 };
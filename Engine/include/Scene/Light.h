@@ -1,6 +1,6 @@
 #pragma once
 
-#include "VkRenderer/Buffer.h"
+#include "VkRenderer/UniformRing.h"
 
 #include "Editor.h"
 
@@ -14,11 +14,14 @@ public:
 	Vec3	_color		= { 1.f, 1.f, 1.f };
 	float	_range		= 10.f;
 
-	Buffer	_ubo;
+	// pos, intensity, color and range, rewritten in the UniformRing every frame
+	static constexpr uint32_t UBO_SIZE = sizeof(float) * 8;
+
+	uint32_t _uboOffset = 0;
 
 public:
 	Light(const Vec3& pos, const float intensity, const Vec3& color, const float range);
 
 public:
-
+	void Update();
 };
\ No newline at end of file
@@ -1,24 +1,112 @@
 #pragma once
 
 #include <vector>
+#include <array>
 
 #include "VkRenderer/Material.h"
 #include "VkRenderer/Buffer.h"
+#include "Scene/Meshlet.h"
 
 class Mesh
 {
 public:
+	enum ImportFlag
+	{
+		OPTIMIZE_VERTEX_CACHE	= 1 << 0,
+		OPTIMIZE_OVERDRAW		= 1 << 1,
+		OPTIMIZE_VERTEX_FETCH	= 1 << 2,
+		GENERATE_LODS			= 1 << 3,
+		BUILD_MESHLETS			= 1 << 4
+	};
+
+	static constexpr int DEFAULT_IMPORT_FLAGS = OPTIMIZE_VERTEX_CACHE | OPTIMIZE_VERTEX_FETCH | GENERATE_LODS;
+
+	// Bit of a Vertex::Format in the formats a mesh is built with
+	static constexpr int FormatBit(const Vertex::Format kFormat) { return 1 << static_cast<int>(kFormat); }
+
+	// What the materials use, every other format costs its streams in device memory
+	static constexpr int DEFAULT_VERTEX_FORMATS = 1 << static_cast<int>(Vertex::Format::COMPACT);
+
+	// Simplified index ranges drawn with the vertices of the full resolution mesh
+	struct Lod
+	{
+		uint32_t	_indexOffset	= 0;
+		uint32_t	_indexCount		= 0;
+		float		_error			= 0.f;	// in mesh units
+	};
+
+	static constexpr size_t	MAX_LOD_COUNT	= 5;
+	static constexpr float	LOD_PIXEL_ERROR	= 1.f;	// largest error on screen allowed when picking a LOD
+
+public:
+	// Only filled when the mesh is imported from its source file, cached meshes go straight to the GPU
 	std::vector<Vertex>		_vertices;
-	std::vector<uint32_t>	_indices;
+	std::vector<uint32_t>	_indices;		// every LOD, one after the other
+
+	uint32_t				_indexCount		= 0;
+	int						_importFlags	= DEFAULT_IMPORT_FLAGS;
+	int						_vertexFormats	= DEFAULT_VERTEX_FORMATS;	// FormatBit of the formats with streams
+
+	std::vector<Lod>		_lods;
+
+	Vec3					_boundsCenter	= { 0.f, 0.f, 0.f };
+	float					_boundsRadius	= 0.f;
+
+	// COMPACT positions are quantized in the bounding cube of the vertices: the same scale on every axis
+	// keeps the direction of the normals once it is folded in the model matrix
+	Vec3					_quantizationOffset	= { 0.f, 0.f, 0.f };
+	float					_quantizationScale	= 1.f;
+
+	// Built from LOD 0 with BUILD_MESHLETS, kept on CPU for culling.
+	// _meshletsBuffer holds the meshlets, then their vertices at _meshletVerticesOffset and triangles at _meshletTrianglesOffset
+	MeshletData				_meshletData;
+	Buffer					_meshletsBuffer;
+	VkDeviceSize			_meshletVerticesOffset	= 0;
+	VkDeviceSize			_meshletTrianglesOffset	= 0;
 
 	Buffer					_indicesBuffer;
-	Buffer					_verticesBuffer;
+
+	struct VertexStreams
+	{
+		Buffer _positions;
+		Buffer _attributes;
+	};
+
+	// Streams of the Vertex::Formats in _vertexFormats, empty for the others.
+	// Materials only bind the streams of their format and data flags
+	std::array<VertexStreams, static_cast<size_t>(Vertex::Format::COUNT)> _verticesBuffers;
+
+	uint64_t				_uploadTicket	= 0;	// UploadBatcher ticket of the buffers
 
 public:
-	Mesh(const std::string kPath);
+	Mesh(const std::string kPath, const int kImportFlags = DEFAULT_IMPORT_FLAGS, const int kVertexFormats = DEFAULT_VERTEX_FORMATS);
 	~Mesh() = default;
 
+private:
+	void Import(const std::string& kPath);
+	void Optimize(const std::string& kPath);
+	void ComputeBounds();
+	void GenerateLods(const std::string& kPath);
+	void GenerateMeshlets(const std::string& kPath);
+
+	bool LoadCache(const std::string& kCachePath);
+	void SaveCache(const std::string& kCachePath) const;
+
+	void Upload(const Vertex* kVertices, const size_t kVertexCount, const uint32_t* kIndices, const size_t kIndexCount);
+	void UploadMeshlets();
+
 public:
-	void Draw(const CommandBuffer& commandBuffer) const;
+	// Drawing doesn't need to wait for it, the upload is submitted before the frame
+	bool IsUploaded() const;
+
+	// Coarsest LOD whose error stays under LOD_PIXEL_ERROR, kPixelsPerUnit being the size of one mesh unit on screen
+	size_t SelectLod(const float kPixelsPerUnit) const;
+
+	// Maps the positions of the kFormat streams to mesh units, to be applied before the model matrix
+	Mat4 GetDequantization(const Vertex::Format kFormat) const;
+
+	// The index and vertex buffers already bound in the recorder are skipped
+	void Draw(CommandRecorder& recorder, const Vertex::Format kFormat = Vertex::Format::COMPACT,
+				const int kVertexDataFlags = Vertex::POSITION | Vertex::ATTRIBUTE_FLAGS, const size_t kLod = 0) const;
 
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "VkRenderer/Material.h"
+
+// Index/vertex reordering applied on import, everything runs on CPU only
+
+struct VertexCacheStatistics
+{
+	uint32_t	_transformedVertices	= 0;
+	float		_acmr					= 0.f;	// transformed vertices per triangle, 0.5 at best and 3 at worst
+	float		_atvr					= 0.f;	// transformed vertices per vertex, 1 at best
+};
+
+// Triangles using each vertex, stored contiguously: the ones of vertex v are _triangles[_offsets[v]] to _triangles[_offsets[v + 1]]
+struct TriangleAdjacency
+{
+	std::vector<uint32_t>	_offsets;
+	std::vector<uint32_t>	_triangles;
+};
+
+// Rebuilding an adjacency reuses its storage
+void BuildTriangleAdjacency(const std::vector<uint32_t>& kIndices, const size_t kVertexCount, TriangleAdjacency& adjacency);
+
+// Simulates a FIFO post-transform cache of kCacheSize entries
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& kIndices, const size_t kVertexCount, const uint32_t kCacheSize = 16);
+
+// Reorders triangles for vertex cache locality (Tipsify, Sander et al. 2007)
+void OptimizeVertexCache(std::vector<uint32_t>& indices, const size_t kVertexCount, const uint32_t kCacheSize = 16);
+
+// Reorders clusters of a cache optimized index buffer so outward facing clusters are drawn first.
+// Clusters are only split where the ACMR stays under kThreshold times the one of the cluster
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& kVertices,
+						const float kThreshold = 1.05f, const uint32_t kCacheSize = 16);
+
+// Reorders vertices by first use in the index buffer and drops unused ones
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
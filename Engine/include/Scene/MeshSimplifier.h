@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include "VkRenderer/Material.h"
+
+// Quadric error metric edge collapse (Garland & Heckbert 1997), runs on CPU only.
+// Vertices are only collapsed onto existing ones so the result can share the vertex buffer of the source.
+// Vertices on a border or on an attribute seam are locked to keep the silhouette and the uv mapping
+
+// Returns simplified indices, stops at kTargetIndexCount or when every collapse left would move the surface
+// by more than kTargetError (in mesh units). resultError gets the largest error of the collapses done
+std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t>& kIndices, const std::vector<Vertex>& kVertices,
+									const size_t kTargetIndexCount, const float kTargetError, float* resultError = nullptr);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "VkRenderer/Material.h"
+
+constexpr uint32_t MESHLET_MAX_VERTICES		= 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES	= 124;
+
+// Small cluster of triangles with its culling bounds, laid out for a std430 storage buffer
+struct Meshlet
+{
+	// Bounding sphere
+	Vec3		_center;
+	float		_radius;
+
+	// Normal cone, every triangle is backfacing for a camera inside it
+	Vec3		_coneApex;
+	float		_coneCutoff;		// sine of the cone half angle, 1 if the cone can't cull
+	Vec3		_coneAxis;
+
+	uint32_t	_vertexOffset;		// first entry in MeshletData::_vertices
+	uint32_t	_triangleOffset;	// first triangle in MeshletData::_triangles, also the first triangle in the mesh indices
+	uint32_t	_vertexCount;
+	uint32_t	_triangleCount;
+	uint32_t	_padding;
+};
+
+static_assert(sizeof(Meshlet) == 64, "Meshlet doesn't match its GPU layout");
+
+struct MeshletData
+{
+	std::vector<Meshlet>	_meshlets;
+	std::vector<uint32_t>	_vertices;	// mesh vertex of every meshlet vertex
+	std::vector<uint8_t>	_triangles;	// 3 meshlet vertices per triangle
+};
+
+// Planes pointing inside, normalized
+struct Frustum
+{
+	Vec4 _planes[6];
+};
+
+// Splits the triangles in order, so a cache optimized index buffer gives compact meshlets
+// and each meshlet is a contiguous range of kIndices
+MeshletData BuildMeshlets(const std::vector<uint32_t>& kIndices, const std::vector<Vertex>& kVertices,
+							const uint32_t kMaxVertices = MESHLET_MAX_VERTICES, const uint32_t kMaxTriangles = MESHLET_MAX_TRIANGLES);
+
+Frustum ExtractFrustum(const Mat4& kViewProjection);
+
+// Both tests take the camera and the frustum in mesh space
+bool IsMeshletBackfacing(const Meshlet& kMeshlet, const Vec3& kCameraPos);
+bool IsMeshletInFrustum(const Meshlet& kMeshlet, const Frustum& kFrustum);
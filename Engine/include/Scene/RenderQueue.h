@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "Scene/Actor.h"
+#include "VkRenderer/CommandRecorder.h"
+
+// Draws of a viewport sorted on a 64 bits key so that consecutive draws share as much state as they can.
+// Opaque draws are keyed by pipeline, material instance, mesh then depth, front to back for early depth rejection.
+// Transparent draws come after them keyed by depth first, back to front for the blending to be right
+class RenderQueue
+{
+public:
+	enum class Pass : uint8_t
+	{
+		OPAQUE		= 0,
+		TRANSPARENT	= 1
+	};
+
+	static constexpr uint32_t PASS_BITS		= 2;
+	static constexpr uint32_t PIPELINE_BITS	= 12;
+	static constexpr uint32_t MATERIAL_BITS	= 14;
+	static constexpr uint32_t MESH_BITS		= 12;
+	static constexpr uint32_t DEPTH_BITS	= 24;
+
+	struct Packet
+	{
+		uint64_t		_key	= 0;
+		const Actor*	_actor	= nullptr;
+		size_t			_lod	= 0;
+	};
+
+public:
+	std::vector<Packet>	_packets;
+
+private:
+	std::vector<Packet>	_sortBuffer;
+
+	// Ids of the states in the keys, in the order they are first pushed
+	std::unordered_map<uint64_t, uint32_t>		_pipelineIds;
+	std::unordered_map<const void*, uint32_t>	_materialIds;
+	std::unordered_map<const void*, uint32_t>	_meshIds;
+
+public:
+	// kDepth is a distance to the camera, only its order is kept
+	static uint64_t MakeKey(const Pass kPass, const uint32_t kPipelineId, const uint32_t kMaterialId, const uint32_t kMeshId, const float kDepth);
+
+	// Empties the queue, the ids are kept
+	void Clear();
+	// Nothing is pushed for an actor without a drawable material
+	void Push(const Actor& kActor, const Camera* kCamera, const float kViewportHeight);
+
+	// Stable LSD radix sort on the keys, the bytes every key shares are skipped
+	void Sort();
+
+	void Draw(CommandRecorder& recorder, const DynamicOffsets& kDynamicOffsets) const;
+};
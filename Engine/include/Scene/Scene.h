@@ -3,12 +3,15 @@
 #include <vector>
 
 #include "Scene/Actor.h"
+#include "Scene/Camera.h"
 #include "VkRenderer/Viewport.h"
 
 struct Scene
 {
 	std::vector<Actor*>		_actors;
 	std::vector<Viewport*>	_viewports;
+
+	const Camera*			_camera		= nullptr;	// used to pick the LOD of the actors
 };
 
 void Draw(const Scene& scene);
\ No newline at end of file
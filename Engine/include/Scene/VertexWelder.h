@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+#include "VkRenderer/Material.h"
+
+// Flat open-addressing table welding equal vertices together.
+// Slots only store the vertex index and its hash, vertices themselves live in the welded array.
+class VertexWelder
+{
+	struct Slot
+	{
+		uint32_t _hash	= 0;
+		uint32_t _index	= EMPTY_SLOT;
+	};
+
+	static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+	std::vector<Vertex>&	_vertices;
+
+	std::vector<Slot>		_slots;
+	size_t					_mask		= 0;
+	size_t					_count		= 0;
+
+public:
+	VertexWelder(std::vector<Vertex>& vertices, const size_t kExpectedVertexCount);
+
+private:
+	void Grow();
+
+public:
+	// Returns the index of the vertex in the welded array and whether it was just added to it
+	std::pair<uint32_t, bool> Weld(const Vertex& kVertex);
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace ez
+{
+	// Non owning view of contiguous elements, stands in for std::span until the engine moves to C++20
+	template<typename T>
+	class Span final
+	{
+		T*		_data	= nullptr;
+		size_t	_size	= 0;
+
+	public:
+		constexpr Span() = default;
+		constexpr Span(T* data, const size_t kSize) : _data{ data }, _size{ kSize } {}
+
+		template<size_t N>
+		constexpr Span(T (&array)[N]) : _data{ array }, _size{ N } {}
+
+		// Any contiguous container, std::vector or std::array
+		template<typename Container, typename = decltype(std::data(std::declval<Container&>()))>
+		constexpr Span(Container& container) : _data{ std::data(container) }, _size{ std::size(container) } {}
+
+	public:
+		constexpr T*		Data() const		{ return _data; }
+		constexpr size_t	Size() const		{ return _size; }
+		constexpr size_t	SizeBytes() const	{ return _size * sizeof(T); }
+		constexpr bool		Empty() const		{ return _size == 0; }
+
+		constexpr T& operator[](const size_t kIndex) const { return _data[kIndex]; }
+
+		constexpr T* begin() const	{ return _data; }
+		constexpr T* end() const	{ return _data + _size; }
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace ez
+{
+	// Fixed set of worker threads consuming a FIFO of tasks
+	class ThreadPool final
+	{
+		static ThreadPool* _sInstance;
+
+		std::vector<std::thread>			_workers;
+		std::queue<std::function<void()>>	_tasks;
+
+		std::mutex							_mutex;
+		std::condition_variable				_condition;
+		bool								_stop		= false;
+
+	public:
+		ThreadPool(const size_t kThreadCount = std::thread::hardware_concurrency());
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool& kThreadPool) = delete;
+		ThreadPool& operator=(const ThreadPool& kThreadPool) = delete;
+
+	private:
+		void Work();
+
+	public:
+		template<typename F>
+		auto Enqueue(F&& task) -> std::future<decltype(task())>;
+
+		size_t Size() const;
+
+		static ThreadPool& Instance();
+	};
+}
+
+#include "ThreadPool.inl"
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <memory>
+
+namespace ez
+{
+	template<typename F>
+	auto ThreadPool::Enqueue(F&& task) -> std::future<decltype(task())>
+	{
+		using ReturnType = decltype(task());
+
+		auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<F>(task));
+		std::future<ReturnType> future = packagedTask->get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.emplace([packagedTask]() { (*packagedTask)(); });
+		}
+		_condition.notify_one();
+
+		return future;
+	}
+}
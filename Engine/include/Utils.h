@@ -7,6 +7,15 @@ namespace ez
 {
 	const char* GetReadableBytes(uint64_t bytes);
 
+	// 64 bits hash of a blob, not cryptographic, stable across runs and platforms of the same endianness
+	uint64_t HashBytes(const void* kData, const size_t kSize);
+
+	// kValue rounded up to a multiple of kAlignment, which is a power of two
+	constexpr uint64_t AlignUp(const uint64_t kValue, const uint64_t kAlignment)
+	{
+		return (kValue + kAlignment - 1) & ~(kAlignment - 1);
+	}
+
 	class Timer final
 	{
 		std::chrono::high_resolution_clock::time_point _startTimestamp;
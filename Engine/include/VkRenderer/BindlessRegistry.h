@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <vector>
+#include <mutex>
+
+#include "Buffer.h"
+
+class Texture;
+
+// One set holding every texture in two arrays, 2D and cubemaps, and the MaterialData of the materials drawn bindless.
+// The shaders index the arrays with the texture indices of the MaterialData pushed with the draw, so the set is bound
+// once for every draw. Only usable with LogicalDevice::_descriptorIndexing, else nothing is registered
+class BindlessRegistry
+{
+public:
+	static constexpr uint32_t MAX_TEXTURES		= 4096;
+	static constexpr uint32_t MAX_CUBEMAPS		= 64;
+	static constexpr uint32_t MAX_MATERIALS		= 1024;
+	static constexpr uint32_t MATERIAL_TEXTURES	= 8;
+	static constexpr uint32_t INVALID_INDEX		= UINT32_MAX;
+
+	// Bindings of the set, the shaders declare them the same way
+	enum Binding : uint32_t
+	{
+		TEXTURES	= 0,	// sampler2D[]
+		CUBEMAPS	= 1,	// samplerCube[]
+		MATERIALS	= 2		// MaterialData[] storage buffer
+	};
+
+	// Indices of the textures a material reads, in the array matching their type, INVALID_INDEX when unused
+	struct MaterialData
+	{
+		std::array<uint32_t, MATERIAL_TEXTURES> _textures;
+	};
+
+private:
+	static BindlessRegistry* _sInstance;
+
+public:
+	VkDescriptorSetLayout	_layout		= VK_NULL_HANDLE;
+	VkDescriptorPool		_pool		= VK_NULL_HANDLE;
+	VkDescriptorSet			_set		= VK_NULL_HANDLE;
+
+	Buffer					_materials;
+
+private:
+	// Freed indices come back once the GPU is done with the frames using them
+	std::vector<uint32_t>	_freeTextures;
+	std::vector<uint32_t>	_freeCubemaps;
+	std::vector<uint32_t>	_freeMaterials;
+	uint32_t				_textureCount	= 0;
+	uint32_t				_cubemapCount	= 0;
+	uint32_t				_materialCount	= 0;
+
+	std::mutex				_mutex;
+
+public:
+	BindlessRegistry();
+	~BindlessRegistry();
+
+	BindlessRegistry(const BindlessRegistry& kBindlessRegistry) = delete;
+	BindlessRegistry& operator=(const BindlessRegistry& kBindlessRegistry) = delete;
+
+private:
+	uint32_t	AllocateIndex(std::vector<uint32_t>& freeIndices, uint32_t& count, const uint32_t kMax);
+	void		FreeIndex(std::vector<uint32_t>& freeIndices, const uint32_t kIndex);
+
+public:
+	static BindlessRegistry& Instance();
+
+	bool IsEnabled() const;
+
+	// Index in CUBEMAPS for cubemaps, in TEXTURES for the others, INVALID_INDEX when disabled
+	uint32_t	RegisterTexture(const Texture& kTexture);
+	void		UnregisterTexture(const Texture& kTexture, const uint32_t kIndex);
+
+	// Index of the MaterialData in MATERIALS, INVALID_INDEX when disabled
+	uint32_t	RegisterMaterial(const MaterialData& kData);
+	void		UnregisterMaterial(const uint32_t kIndex);
+};
@@ -3,17 +3,35 @@
 #include <vulkan/vulkan.h>
 
 #include "Device.h"
+#include "MemoryAllocator.h"
+#include "Span.h"
+
+class CommandBuffer;
 
 class Buffer
 {
 public:
-	VkDeviceSize	_size	= 0;
-	VkBuffer		_buffer = VK_NULL_HANDLE;
-	VkDeviceMemory	_memory = VK_NULL_HANDLE;
+	enum class MemoryUsage
+	{
+		DEVICE_LOCAL,	// GPU only, filled with Upload or a copy
+		UPLOAD,			// CPU writes, GPU reads
+		READBACK		// GPU writes, CPU reads
+	};
+
+public:
+	VkDeviceSize	_size			= 0;
+	VkBuffer		_buffer			= VK_NULL_HANDLE;
+	Allocation		_allocation;
+	MemoryUsage		_memoryUsage	= MemoryUsage::UPLOAD;
+
+private:
+	// Range written since the last Flush, only tracked for non coherent memory
+	mutable VkDeviceSize	_dirtyBegin	= VK_WHOLE_SIZE;
+	mutable VkDeviceSize	_dirtyEnd	= 0;
 
 public:
 	Buffer() = default;
-	Buffer(const VkDeviceSize kSize, const VkBufferUsageFlags kUsage);
+	Buffer(const VkDeviceSize kSize, const VkBufferUsageFlags kUsage, const MemoryUsage kMemoryUsage = MemoryUsage::UPLOAD);
 
 	~Buffer();
 
@@ -27,12 +45,30 @@ private:
 	void Clean();
 
 public:
-	void Map(void* data, size_t size, size_t offset = 0) const;
+	// Host visible buffers are mapped for their whole life, writes are plain copies in the mapped memory
+	void Write(const void* data, size_t size, size_t offset = 0) const;
+
+	template<typename T>
+	void Write(const T& kValue, size_t offset = 0) const;
+	template<typename T>
+	void Write(ez::Span<const T> kValues, size_t offset = 0) const;
+
+	// Makes the writes visible to the GPU with a single flush of every range written, no-op on coherent memory
+	void Flush() const;
+
+	void Read(void* data, size_t size, size_t offset = 0) const;
+
+	// Goes through a staging buffer, waits for the copy to be done
+	void Upload(const Queue& kQueue, const void* data, size_t size, size_t offset = 0) const;
 
 	void CopyBuffer(const Queue& kQueue, const Buffer& kSrcBuffer) const;
+	void CopyBuffer(const CommandBuffer& kCommandBuffer, const Buffer& kSrcBuffer, const VkDeviceSize kSize,
+					const VkDeviceSize kSrcOffset = 0, const VkDeviceSize kDstOffset = 0) const;
 
 	const VkDescriptorBufferInfo CreateDescriptorInfo() const;
 
 public:
 	operator const VkBuffer&() const;
-};
\ No newline at end of file
+};
+
+#include "Buffer.inl"
\ No newline at end of file
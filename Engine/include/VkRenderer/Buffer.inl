@@ -0,0 +1,19 @@
+#pragma once
+
+#include <type_traits>
+
+#include "Buffer.h"
+
+template<typename T>
+void Buffer::Write(const T& kValue, size_t offset) const
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T has to be trivially copyable to be written in a buffer");
+	Write(&kValue, sizeof(T), offset);
+}
+
+template<typename T>
+void Buffer::Write(ez::Span<const T> kValues, size_t offset) const
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T has to be trivially copyable to be written in a buffer");
+	Write(kValues.Data(), kValues.SizeBytes(), offset);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+
+#include "CommandBuffer.h"
+#include "Span.h"
+
+// Records the binds of a CommandBuffer, the ones matching what is already bound are skipped.
+// The state starts empty, a recorder is made once the command buffer began and lives until it ends
+class CommandRecorder
+{
+public:
+	static constexpr uint32_t MAX_SETS				= 8;
+	static constexpr uint32_t MAX_DYNAMIC_OFFSETS	= 16;
+	static constexpr uint32_t MAX_VERTEX_BUFFERS	= 4;
+
+	struct Stats
+	{
+		uint32_t	_binds		= 0;	// vkCmdBind* recorded
+		uint32_t	_elided		= 0;	// pipelines, sets and buffers already bound, skipped
+	};
+
+private:
+	const CommandBuffer&	_commandBuffer;
+
+	VkPipeline				_pipeline		= VK_NULL_HANDLE;
+	VkPipelineLayout		_pipelineLayout	= VK_NULL_HANDLE;
+
+	std::array<VkDescriptorSet, MAX_SETS>		_sets{};
+	std::array<uint32_t, MAX_SETS>				_offsetCounts{};
+	std::array<uint32_t, MAX_DYNAMIC_OFFSETS>	_dynamicOffsets{};
+
+	VkBuffer				_indexBuffer		= VK_NULL_HANDLE;
+	VkDeviceSize			_indexOffset		= 0;
+	VkIndexType				_indexType			= VK_INDEX_TYPE_UINT32;
+
+	std::array<VkBuffer, MAX_VERTEX_BUFFERS>		_vertexBuffers{};
+	std::array<VkDeviceSize, MAX_VERTEX_BUFFERS>	_vertexOffsets{};
+
+public:
+	Stats					_stats;
+
+public:
+	explicit CommandRecorder(const CommandBuffer& kCommandBuffer);
+
+	CommandRecorder(const CommandRecorder& kCommandRecorder) = delete;
+	CommandRecorder& operator=(const CommandRecorder& kCommandRecorder) = delete;
+
+public:
+	void BindPipeline(const VkPipeline kPipeline);
+
+	// kDynamicOffsets are the offsets of every set one after the other, kOffsetCounts[i] of them belong to kSets[i].
+	// A new layout drops every set, else only the sets from the first one which changed are bound, in a single call
+	void BindDescriptorSets(const VkPipelineLayout kLayout, ez::Span<const VkDescriptorSet> kSets,
+							ez::Span<const uint32_t> kDynamicOffsets, ez::Span<const uint32_t> kOffsetCounts);
+
+	void BindIndexBuffer(const VkBuffer kBuffer, const VkDeviceSize kOffset, const VkIndexType kType);
+	void BindVertexBuffer(const uint32_t kBinding, const VkBuffer kBuffer, const VkDeviceSize kOffset);
+
+public:
+	// Everything else is recorded straight in the command buffer
+	operator const CommandBuffer& () const;
+};
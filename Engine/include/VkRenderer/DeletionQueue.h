@@ -0,0 +1,44 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <mutex>
+
+#include "GpuTimeline.h"
+
+// Holds back the destruction of the resources the GPU may still use.
+// What is released during a frame is tagged with the timeline once the frame is submitted, and destroyed when the GPU reached it
+class DeletionQueue
+{
+	static DeletionQueue* _sInstance;
+
+	struct Entry
+	{
+		GpuTimeline::Point		_point;
+		std::function<void()>	_release;
+	};
+
+	std::vector<std::function<void()>>	_frameReleases;	// released since the last Update, not tagged yet
+	std::deque<Entry>					_entries;
+
+	std::mutex	_mutex;
+
+public:
+	DeletionQueue();
+	~DeletionQueue();
+
+	DeletionQueue(const DeletionQueue& kDeletionQueue) = delete;
+	DeletionQueue& operator=(const DeletionQueue& kDeletionQueue) = delete;
+
+public:
+	static DeletionQueue& Instance();
+
+	// Without a deletion queue nothing can be in flight, release runs straight away
+	static void Push(std::function<void()>&& release);
+
+	// Once per frame, after the submissions of the previous frame
+	void Update();
+	// Waits for everything submitted and releases it all
+	void Flush();
+};
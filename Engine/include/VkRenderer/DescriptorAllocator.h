@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+#include "Span.h"
+#include "GpuTimeline.h"
+
+// One descriptor of a set, the sets are written from arrays of these in a single call
+union DescriptorInfo
+{
+	VkDescriptorBufferInfo	_buffer;
+	VkDescriptorImageInfo	_image;
+};
+
+// Hands out the descriptor sets of the materials without ever freeing them one by one.
+// Each layout has its own chain of pools sized for it, a released set goes back to the chain and is rewritten by the next user.
+// Sets written with the same resources are shared, they are never written again once acquired.
+// Transient sets only live for a frame, their pools are reset at once when the GPU is done with the frame
+class DescriptorAllocator
+{
+	static DescriptorAllocator* _sInstance;
+
+	static constexpr uint32_t FIRST_POOL_SETS	= 16;
+	static constexpr uint32_t MAX_POOL_SETS		= 1024;
+	static constexpr uint32_t FRAME_POOL_SETS	= 256;
+
+	struct PoolChain
+	{
+		std::vector<VkDescriptorPoolSize>	_setSizes;	// descriptors of one set
+		std::vector<VkDescriptorType>		_types;		// of each DescriptorInfo of a set
+		VkDescriptorUpdateTemplate			_template	= VK_NULL_HANDLE;
+		std::vector<VkDescriptorPool>		_pools;
+		std::vector<VkDescriptorSet>		_freeSets;
+		uint32_t							_nextPoolSets	= FIRST_POOL_SETS;
+	};
+
+	struct CachedSet
+	{
+		std::vector<uint64_t>	_key;
+		VkDescriptorSetLayout	_layout			= VK_NULL_HANDLE;
+		VkDescriptorSet			_set			= VK_NULL_HANDLE;
+		uint32_t				_references		= 0;
+	};
+
+	struct FramePools
+	{
+		std::vector<VkDescriptorPool>	_pools;
+		size_t							_current	= 0;
+		GpuTimeline::Point				_point{};
+	};
+
+	std::unordered_map<VkDescriptorSetLayout, PoolChain>	_chains;
+	std::unordered_map<uint64_t, CachedSet>					_cache;
+	std::unordered_map<VkDescriptorSet, uint64_t>			_cacheKeys;
+
+	std::vector<FramePools>	_frames;
+	size_t					_frameIndex		= 0;
+
+	std::mutex	_mutex;
+
+public:
+	DescriptorAllocator(const uint32_t kFrameCount = 3);
+	~DescriptorAllocator();
+
+	DescriptorAllocator(const DescriptorAllocator& kDescriptorAllocator) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator& kDescriptorAllocator) = delete;
+
+private:
+	VkDescriptorPool	CreatePool(ez::Span<const VkDescriptorPoolSize> kSetSizes, const uint32_t kSetCount) const;
+	VkDescriptorSet		AllocateFromChain(const VkDescriptorSetLayout kLayout);
+
+public:
+	static DescriptorAllocator& Instance();
+
+	// The bindings size the pools of the layout and give the order of the DescriptorInfos of its sets.
+	// Unregistering destroys the pools with every set they hold
+	void RegisterLayout(const VkDescriptorSetLayout kLayout, ez::Span<const VkDescriptorSetLayoutBinding> kBindings);
+	void UnregisterLayout(const VkDescriptorSetLayout kLayout);
+
+	// A set of kLayout holding kInfos, one per descriptor in binding order. Left unwritten without infos.
+	// The same layout and resources give the same set
+	VkDescriptorSet Acquire(const VkDescriptorSetLayout kLayout, ez::Span<const DescriptorInfo> kInfos);
+	// Back to the chain once no one acquired it and the GPU is done with it
+	void Release(const VkDescriptorSet kSet);
+
+	// Valid until the frame comes back around, written with kInfos like Acquire, left unwritten without them
+	VkDescriptorSet AllocateTransient(const VkDescriptorSetLayout kLayout, ez::Span<const DescriptorInfo> kInfos = {});
+
+	// Once per frame, after the submissions of the previous frame
+	void Update();
+};
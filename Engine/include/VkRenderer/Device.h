@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 
 #include <vector>
+#include <string>
 
 #include "Editor.h"
 
@@ -31,6 +32,8 @@ public:
 	~Device() = default;
 
 public:
+	bool IsExtensionSupported(const std::string& kName) const;
+
 	uint32_t FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags properties) const;
 
 	VkFormat FindDepthFormat() const;
@@ -48,12 +51,29 @@ public:
 	Queue				_computeQueue;
 	Queue				_transferQueue;
 
+	// ImGui and the viewports, the materials go through the DescriptorAllocator
 	VkDescriptorPool	_descriptorPool		= VK_NULL_HANDLE;
 
+	// VK_EXT_shader_module_identifier, pipelines can be looked up in the cache without creating their shader modules
+	bool				_shaderModuleIdentifier	= false;
+
+	// Descriptor indexing, the textures can be bound once for every draw by the BindlessRegistry
+	bool				_descriptorIndexing		= false;
+
+	// Shared by every pipeline, loaded at startup and saved back on destruction
+	VkPipelineCache		_pipelineCache		= VK_NULL_HANDLE;
+	std::string			_pipelineCachePath;
+
 public:
-	LogicalDevice(const Device& kDevice);
+	LogicalDevice(const Device& kDevice, const std::string& kPipelineCachePath = "pipeline.cache");
 	~LogicalDevice();
 
+private:
+	bool IsPipelineCacheValid(const void* kData, const size_t kSize) const;
+
+	void CreatePipelineCache();
+	void SavePipelineCache() const;
+
 public:
 	static const LogicalDevice& Instance();
 };
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <mutex>
+
+#include "Span.h"
+#include "Device.h"
+
+// One timeline semaphore per queue, every submission signals the next value of its queue.
+// The progress of the GPU is read from the semaphores, any submission can be polled or waited without a fence
+class GpuTimeline
+{
+public:
+	enum class QueueType
+	{
+		GRAPHICS,
+		COMPUTE,
+		TRANSFER,
+		COUNT
+	};
+
+	// One value per queue, reached once each queue reached its own
+	using Point = std::array<uint64_t, static_cast<size_t>(QueueType::COUNT)>;
+
+	// Makes a submission wait for the work of another queue
+	struct WaitInfo
+	{
+		const Queue*			_queue	= nullptr;
+		uint64_t				_value	= 0;
+		VkPipelineStageFlags	_stage	= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	};
+
+private:
+	static GpuTimeline* _sInstance;
+
+	std::array<VkSemaphore, static_cast<size_t>(QueueType::COUNT)>	_semaphores{};
+	Point			_submitted{};	// last value signaled by a submission on each queue
+	mutable Point	_completed{};	// last value read back from each semaphore
+
+	mutable std::mutex	_mutex;
+
+public:
+	GpuTimeline();
+	~GpuTimeline();
+
+	GpuTimeline(const GpuTimeline& kGpuTimeline) = delete;
+	GpuTimeline& operator=(const GpuTimeline& kGpuTimeline) = delete;
+
+private:
+	static size_t GetIndex(const Queue& kQueue);
+
+	uint64_t GetCompletedValue(const size_t kIndex) const;
+
+public:
+	static GpuTimeline& Instance();
+
+	// Submits kSubmitInfo on kQueue with the signal of its next value added, and returns that value.
+	// The binary semaphores of kSubmitInfo are kept, kWaits are added to them
+	uint64_t Submit(const Queue& kQueue, const VkSubmitInfo& kSubmitInfo, ez::Span<const WaitInfo> kWaits = {});
+
+	uint64_t	GetCompletedValue(const Queue& kQueue) const;
+	bool		IsComplete(const Queue& kQueue, const uint64_t kValue) const;
+	bool		IsComplete(const Point& kPoint) const;
+
+	void		Wait(const Queue& kQueue, const uint64_t kValue) const;
+	void		Wait(const Point& kPoint) const;
+
+	// Reached once everything submitted so far is done
+	Point		GetSubmittedPoint() const;
+};
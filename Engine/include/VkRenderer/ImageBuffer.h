@@ -5,11 +5,13 @@
 #include "Device.h"
 #include "Buffer.h"
 
+class CommandBuffer;
+
 class ImageBuffer
 {
 public:
 	VkExtent2D		_size;
-	VkDeviceMemory	_memory	= VK_NULL_HANDLE;
+	Allocation		_allocation;
 	VkImage			_image	= VK_NULL_HANDLE;
 	VkImageView		_view	= VK_NULL_HANDLE;
 
@@ -33,6 +35,11 @@ private:
 	void Clean();
 
 public:
+	VkImageSubresourceRange GetSubresourceRange() const;
+
 	void TransitionLayout(const Queue& kQueue, const VkImageLayout kOldLayout, const VkImageLayout kNewLayout) const;
+	void TransitionLayout(const CommandBuffer& kCommandBuffer, const VkImageLayout kOldLayout, const VkImageLayout kNewLayout) const;
+
 	void CopyBuffer(const Queue& kQueue, const Buffer& kBuffer) const;
+	void CopyBuffer(const CommandBuffer& kCommandBuffer, const Buffer& kBuffer) const;
 };
\ No newline at end of file
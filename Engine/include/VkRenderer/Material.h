@@ -3,15 +3,27 @@
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <cstring>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
 
 #include "Viewport.h"
 #include "Texture.h"
 #include "Buffer.h"
+#include "ShaderReflection.h"
+#include "CommandRecorder.h"
+#include "DescriptorAllocator.h"
 
 #include "Wrappers/glm.h"
 
+struct Shader;
+
 struct Vertex
 {
+	// The bit index is the location of the attribute in the vertex shaders
 	enum DataFlag
 	{
 		POSITION = 1 << 0,
@@ -20,51 +32,30 @@ struct Vertex
 		TANGENT = 1 << 3
 	};
 
+	// Layout of the vertices in the GPU streams, a Mesh only keeps the streams of the formats it is built with
+	enum class Format
+	{
+		FLOAT,		// VertexPosition, VertexAttributes: 12 + 32 bytes
+		COMPACT,	// CompactVertexPosition, CompactVertexAttributes: 8 + 12 bytes
+		COUNT
+	};
+
+	// Positions are in their own tightly packed stream so position-only pipelines don't fetch the attributes
+	enum Stream
+	{
+		POSITION_STREAM = 0,
+		ATTRIBUTE_STREAM = 1
+	};
+
+	static constexpr int ATTRIBUTE_FLAGS = UV | NORMAL | TANGENT;
+
 	Vec3 pos;
 	Vec2 uv;
 	Vec3 normal;
 	Vec3 tangent;
 
-	static VkVertexInputBindingDescription getBindingDescription(int kDataFlags) {
-		VkVertexInputBindingDescription bindingDescription{};
-
-		bindingDescription.binding = 0;
-		bindingDescription.stride = sizeof(Vertex);
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-		return bindingDescription;
-	}
-
-	static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(int kDataFlags) {
-		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
-
-		uint8_t locationNb = 0;
-		if (kDataFlags & DataFlag::POSITION)
-		{
-			attributeDescriptions.push_back({ locationNb, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos) });
-			locationNb++;
-		}
-
-		if (kDataFlags & DataFlag::UV)
-		{
-			attributeDescriptions.push_back({ locationNb, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv) });
-			locationNb++;
-		}
-
-		if (kDataFlags & DataFlag::NORMAL)
-		{
-			attributeDescriptions.push_back({ locationNb, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) });
-			locationNb++;
-		}
-
-		if (kDataFlags & DataFlag::TANGENT)
-		{
-			attributeDescriptions.push_back({ locationNb, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent) });
-			locationNb++;
-		}
-
-		return attributeDescriptions;
-	}
+	static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(int kDataFlags, Format kFormat = Format::FLOAT);
+	static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(int kDataFlags, Format kFormat = Format::FLOAT);
 
 	bool operator==(const Vertex& other) const {
 		return pos == other.pos && normal == other.normal && uv == other.uv;
@@ -72,33 +63,89 @@ struct Vertex
 };
 
 namespace std {
+	// Mixes the bits of every compared component (tangent is ignored like in operator==)
 	template<> struct hash<Vertex> {
 		size_t operator()(Vertex const& vertex) const {
-			return ((hash<Vec3>()(vertex.pos) ^
-				(hash<Vec3>()(vertex.normal) << 1)) >> 1) ^
-				(hash<Vec2>()(vertex.uv) << 1);
+			const float components[] = { vertex.pos.x, vertex.pos.y, vertex.pos.z,
+				vertex.uv.x, vertex.uv.y,
+				vertex.normal.x, vertex.normal.y, vertex.normal.z };
+
+			uint64_t hash = 0x9E3779B97F4A7C15ull;
+			for (const float kComponent : components)
+			{
+				// -0.f == 0.f so both have to hash the same
+				const float component = kComponent == 0.f ? 0.f : kComponent;
+
+				uint32_t bits;
+				memcpy(&bits, &component, sizeof(bits));
+
+				hash = (hash ^ bits) * 0xFF51AFD7ED558CCDull;
+				hash ^= hash >> 32;
+			}
+
+			// Final avalanche so the low bits used by power-of-two tables are well distributed
+			hash ^= hash >> 33;
+			hash *= 0xC4CEB9FE1A85EC53ull;
+			hash ^= hash >> 33;
+
+			return static_cast<size_t>(hash);
 		}
 	};
 }
 
-struct Bindings
+struct VertexPosition
 {
-	enum class Stage
-	{
-		VERTEX,
-		FRAGMENT
-	};
+	Vec3 pos;
+
+	VertexPosition() = default;
+	explicit VertexPosition(const Vertex& kVertex);
+};
+
+struct VertexAttributes
+{
+	Vec2 uv;
+	Vec3 normal;
+	Vec3 tangent;
+
+	VertexAttributes() = default;
+	explicit VertexAttributes(const Vertex& kVertex);
+};
+
+// Positions relative to the bounds of their mesh, the model matrix maps them back to mesh units (Mesh::GetDequantization)
+struct CompactVertexPosition
+{
+	int16_t		pos[4];		// snorm of (pos - kOffset) / kScale, w is 1
+
+	CompactVertexPosition() = default;
+	CompactVertexPosition(const Vertex& kVertex, const Vec3& kOffset, const float kScale);
+};
 
+// Shaders reading it have to decode normal and tangent with an octahedral decode
+struct CompactVertexAttributes
+{
+	uint16_t	uv[2];		// half
+	int16_t		normal[2];	// snorm, octahedral
+	int16_t		tangent[2];	// snorm, octahedral
+
+	CompactVertexAttributes() = default;
+	explicit CompactVertexAttributes(const Vertex& kVertex);
+};
+
+// The shaders reflection gives the bindings, only what it can't tell has to be declared
+struct Bindings
+{
 	enum class Type
 	{
 		BUFFER,
-		SAMPLER
+		SAMPLER,
+		DYNAMIC_BUFFER	// bound to the UniformRing, the offset is given when binding the set
 	};
 
-	uint8_t		_binding	= 0;
-	Stage		_stage		= Stage::VERTEX;
-	Type		_type		= Type::BUFFER;
-	uint8_t		_count		= 1;
+	uint8_t				_binding	= 0;
+	Type				_type		= Type::BUFFER;
+	uint32_t			_range		= 0;	// size of the data read by the shader for buffers, the block size when 0
+	uint8_t				_count		= 1;	// reflected
+	VkShaderStageFlags	_stages		= 0;	// reflected, the stages accessing it
 };
 
 struct BindingsSet
@@ -107,42 +154,126 @@ struct BindingsSet
 	{
 		GLOBAL,
 		MATERIAL,
-		ACTOR
+		ACTOR,		// per actor data too big for DrawConstants
+		BINDLESS,	// the set of the BindlessRegistry, the same for every material
+		COUNT
 	};
 
 	Scope _scope	= Scope::MATERIAL;
 
+	// Declared bindings are the dynamic buffers, once built the material holds all of them sorted by binding
 	std::vector<Bindings> _bindings;
 };
 
+// Every dynamic buffer of a set is bound at the offset of the set's scope, ie. the camera for GLOBAL
+using DynamicOffsets = std::array<uint32_t, static_cast<size_t>(BindingsSet::Scope::COUNT)>;
+
+// Pushed with every draw, the shaders declare the members they read in a push_constant block at the same offsets.
+// 84 bytes stay under the 128 bytes every device supports
+struct DrawConstants
+{
+	Mat4		_model;
+	Vec4		_parameters;	// left to the material, ie. the color of the gizmo
+	uint32_t	_materialIndex	= BindlessRegistry::INVALID_INDEX;	// MaterialData of the instance in the BindlessRegistry
+};
+
+// Values of the specialization constants of a pipeline, every constant is 32 bits: bool, int, uint or float
+struct Specialization
+{
+	struct Constant
+	{
+		uint32_t	_id		= 0;
+		uint32_t	_value	= 0;
+	};
+
+	std::vector<Constant>	_constants;		// sorted by id
+
+	Specialization& Set(const uint32_t kId, const bool kValue);
+	Specialization& Set(const uint32_t kId, const int32_t kValue);
+	Specialization& Set(const uint32_t kId, const uint32_t kValue);
+	Specialization& Set(const uint32_t kId, const float kValue);
+
+	// The same constants give the same key whatever the order they were set in, 0 without constants
+	uint64_t Key() const;
+
+	bool operator==(const Specialization& kOther) const;
+};
+
+namespace std {
+	// Equal keys are told apart by operator==, a collision only costs a comparison
+	template<> struct hash<Specialization> {
+		size_t operator()(Specialization const& specialization) const {
+			return static_cast<size_t>(specialization.Key());
+		}
+	};
+}
+
 class Material
 {
+public:
 	struct SetLayout
 	{
 		BindingsSet				_bindingsSet;
 		VkDescriptorSetLayout	_layout			= VK_NULL_HANDLE;
 	};
 
+	// The pipeline of the material for some specialization constants, the shaders are shared by every variant
+	struct Variant
+	{
+		Specialization		_specialization;
+		VkPipeline			_pipeline		= VK_NULL_HANDLE;
+
+		std::future<void>	_build;
+		std::atomic<bool>	_ready			= false;
+
+		bool IsReady() const;
+	};
+
 public:
 	VkPipelineLayout		_pipelineLayout		= VK_NULL_HANDLE;
-	VkPipeline				_pipeline			= VK_NULL_HANDLE;
 
 	std::vector<SetLayout>	_setsLayout;
+	ShaderReflection		_reflection;		// every stage merged
+
+	Vertex::Format			_vertexFormat		= Vertex::Format::FLOAT;
+	int						_vertexDataFlags	= 0;	// the inputs of the vertex shader
+
+	bool					_transparent		= false;	// drawn after the opaque materials, back to front
+
+private:
+	// What the variants are built from, they can be asked for after the constructor
+	VkRenderPass			_renderPass			= VK_NULL_HANDLE;
+	const Shader*			_vertexShader		= nullptr;
+	const Shader*			_fragmentShader		= nullptr;
+	VkCullModeFlagBits		_cullMode			= VK_CULL_MODE_BACK_BIT;
+	bool					_wireframe			= false;
+
+	mutable std::unordered_map<Specialization, std::unique_ptr<Variant>>	_variants;
+	mutable std::mutex		_variantsMutex;
+	const Variant*			_defaultVariant		= nullptr;
 
 public:
+	// The layouts come from the shaders, kSets gives the scope of each set and the dynamic buffers.
+	// The pipeline without specialization constants is compiled on the ThreadPool, the material can't be bound before IsReady
 	Material(const Viewport& kViewport, const std::string kVertextShaderPath,
-		const std::string kFragmentShaderPath, const std::vector<BindingsSet>& kSets, 
+		const std::string kFragmentShaderPath, const std::vector<BindingsSet>& kSets = {},
 		const VkCullModeFlagBits kCullMode = VK_CULL_MODE_BACK_BIT,
-		const int kVertexDataFlags = Vertex::POSITION | Vertex::UV | Vertex::NORMAL | Vertex::TANGENT,
-		const bool kWireframe = false);
+		const bool kWireframe = false, const Vertex::Format kVertexFormat = Vertex::Format::FLOAT);
 	~Material();
 
 private:
 	void CreateDescriptors(const std::vector<BindingsSet>& kSets);
-	void CreatePipeline(const Viewport& kViewport, const std::string kVertextShaderPath,
-							const std::string kFragmentShaderPath, const VkCullModeFlagBits kCullMode,
-							const int kVertexDataFlags = Vertex::POSITION | Vertex::UV | Vertex::NORMAL | Vertex::TANGENT,
-							const bool kWireframe = false);
+	void CreatePipelineLayout();
+	void CreatePipeline(const Specialization& kSpecialization, VkPipeline& pipeline) const;
+
+public:
+	// Compiled on the ThreadPool the first time its constants are asked for, from the same SPIR-V
+	const Variant& GetVariant(const Specialization& kSpecialization) const;
+
+	// Of the variant without specialization constants
+	bool IsReady() const;
+	// Waits for every variant
+	void Wait() const;
 };
 
 class MaterialInstance
@@ -151,15 +282,38 @@ public:
 	const Material* _kMaterial;
 	std::vector<VkDescriptorSet> _sets;
 
+	const MaterialInstance* _fallback = nullptr;	// drawn while _kMaterial is building
+	const Material::Variant* _variant = nullptr;
+
+	Vec4 _parameters{ 0.f };	// DrawConstants::_parameters of every draw of the instance
+	uint32_t _materialIndex = BindlessRegistry::INVALID_INDEX;	// set by SetBindlessTextures
+	uint32_t _transientSets = 0;	// a bit per set written by UpdateTransientSet
+
 public:
-	MaterialInstance(const Material& kMaterial, const std::vector<std::vector<void*>>& kData);
+	MaterialInstance(const Material& kMaterial, const std::vector<std::vector<void*>>& kData, const MaterialInstance* kFallback = nullptr,
+						const Specialization& kSpecialization = {});
 	~MaterialInstance();
 
-public:
-	void Bind(const CommandBuffer& commandBuffer) const;
+private:
+	// kData packed in binding order, the buffers show the block the shaders read at kOffsets
+	std::vector<DescriptorInfo> CreateInfos(const uint8_t kSetIndex, const std::vector<void*>& kData, const std::vector<uint32_t>& kOffsets) const;
 
-	void UpdateSet(const uint8_t kSetIndex, const std::vector<void*>& kData) const;
+public:
+	// This instance once its variant of the material is ready, else the first ready fallback, nullptr if there is none
+	const MaterialInstance* GetDrawable() const;
+
+	// The pipeline and the sets already bound in the recorder are skipped
+	void Bind(CommandRecorder& recorder, const DynamicOffsets& kDynamicOffsets = {}) const;
+	// Only the range the shaders declare is pushed, nothing without push constants
+	void Push(const CommandBuffer& commandBuffer, const DrawConstants& kConstants) const;
+
+	// Binds the set holding kData, the previous one is released
+	void UpdateSet(const uint8_t kSetIndex, const std::vector<void*>& kData);
+	// Binds a set only valid for the current frame, for data moving every frame like a region of the UniformRing.
+	// kOffsets[i] is added to the buffer of kData[i], the missing ones are 0. Called every frame before Bind
+	void UpdateTransientSet(const uint8_t kSetIndex, const std::vector<void*>& kData, const std::vector<uint32_t>& kOffsets);
+	// Registers the MaterialData the BINDLESS set is read with, nullptr leaves a slot unused
+	void SetBindlessTextures(const std::array<const Texture*, BindlessRegistry::MATERIAL_TEXTURES>& kTextures);
 };
 
-VkShaderModule loadShader(std::string path);
 VkPipelineShaderStageCreateInfo createShader(VkShaderModule shaderModule, VkShaderStageFlagBits flags);
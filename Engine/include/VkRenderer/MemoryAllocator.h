@@ -0,0 +1,208 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "Editor.h"
+
+// Two-level segregated fit (Masmoudi et al. 2004) over a range of offsets, allocation and free in constant time.
+// Only does the bookkeeping, it never touches the memory so it runs on CPU only
+class TlsfAllocator
+{
+public:
+	static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+private:
+	static constexpr uint32_t SL_COUNT_LOG2	= 4;
+	static constexpr uint32_t SL_COUNT		= 1 << SL_COUNT_LOG2;
+	static constexpr uint32_t FL_COUNT		= 64 - SL_COUNT_LOG2 + 1;
+
+	struct Block
+	{
+		VkDeviceSize	_offset			= 0;
+		VkDeviceSize	_size			= 0;
+		uint32_t		_prevPhysical	= INVALID_HANDLE;
+		uint32_t		_nextPhysical	= INVALID_HANDLE;
+		uint32_t		_prevFree		= INVALID_HANDLE;
+		uint32_t		_nextFree		= INVALID_HANDLE;
+		bool			_free			= false;
+	};
+
+	std::vector<Block>		_blocks;
+	std::vector<uint32_t>	_unusedBlocks;	// entries of _blocks to recycle
+
+	uint64_t									_flBitmap	= 0;
+	std::array<uint32_t, FL_COUNT>				_slBitmaps{};
+	std::array<uint32_t, FL_COUNT * SL_COUNT>	_freeLists{};
+
+	VkDeviceSize	_size				= 0;
+	VkDeviceSize	_usedSize			= 0;
+	uint32_t		_allocationCount	= 0;
+
+public:
+	TlsfAllocator(const VkDeviceSize kSize);
+
+private:
+	static void Mapping(const VkDeviceSize kSize, uint32_t& fl, uint32_t& sl);
+
+	uint32_t	CreateBlock();
+	void		ReleaseBlock(const uint32_t kBlock);
+
+	void		InsertFree(const uint32_t kBlock);
+	void		RemoveFree(const uint32_t kBlock);
+	uint32_t	FindFree(const VkDeviceSize kSize) const;
+
+	// Keeps the first kSize bytes in kBlock and returns the block made of the rest
+	uint32_t	Split(const uint32_t kBlock, const VkDeviceSize kSize);
+
+public:
+	// Returns INVALID_HANDLE when there is no room left
+	uint32_t Allocate(const VkDeviceSize kSize, const VkDeviceSize kAlignment, VkDeviceSize& offset);
+	void Free(const uint32_t kHandle);
+
+	bool			IsEmpty() const;
+	VkDeviceSize	Size() const;
+	VkDeviceSize	UsedSize() const;
+	uint32_t		AllocationCount() const;
+};
+
+struct MemoryBlock
+{
+	VkDeviceMemory	_memory		= VK_NULL_HANDLE;
+	uint32_t		_memoryType	= 0;
+	TlsfAllocator	_allocator;
+
+	void*			_mapped		= nullptr;	// host visible blocks stay mapped for their whole life
+
+	MemoryBlock(const VkDeviceSize kSize) : _allocator{ kSize } {}
+};
+
+struct Allocation
+{
+	VkDeviceMemory	_memory		= VK_NULL_HANDLE;
+	VkDeviceSize	_offset		= 0;
+	VkDeviceSize	_size		= 0;
+	uint32_t		_memoryType	= 0;
+
+	void*			_mapped		= nullptr;	// start of the allocation, nullptr if it's not host visible
+	bool			_coherent	= true;
+
+	MemoryBlock*	_block		= nullptr;	// nullptr for a dedicated allocation
+	uint32_t		_handle		= TlsfAllocator::INVALID_HANDLE;
+};
+
+// Sub-allocates buffers and images in big blocks of device memory, one set of blocks per memory type
+class MemoryAllocator
+{
+public:
+	// Buffers and optimal images are kept in different blocks so bufferImageGranularity never has to be handled
+	enum class ResourceType
+	{
+		LINEAR,
+		OPTIMAL,
+		COUNT
+	};
+
+	struct Statistics
+	{
+		uint32_t		_blockCount			= 0;
+		uint32_t		_allocationCount	= 0;
+		uint32_t		_dedicatedCount		= 0;
+		VkDeviceSize	_blockBytes			= 0;
+		VkDeviceSize	_usedBytes			= 0;
+		VkDeviceSize	_dedicatedBytes		= 0;
+	};
+
+	static constexpr VkDeviceSize BLOCK_SIZE = 64ull << 20;
+
+private:
+	static MemoryAllocator* _sInstance;
+
+	using BlockList = std::vector<std::unique_ptr<MemoryBlock>>;
+
+	std::array<std::array<BlockList, static_cast<size_t>(ResourceType::COUNT)>, VK_MAX_MEMORY_TYPES>	_blocks;
+	std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES>	_blockSizes{};
+	std::array<uint32_t, VK_MAX_MEMORY_TYPES>		_dedicatedCounts{};
+	std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES>	_dedicatedBytes{};
+
+	mutable std::mutex	_mutex;
+
+public:
+	MemoryAllocator();
+	~MemoryAllocator();
+
+	MemoryAllocator(const MemoryAllocator& kMemoryAllocator) = delete;
+	MemoryAllocator& operator=(const MemoryAllocator& kMemoryAllocator) = delete;
+
+private:
+	Allocation AllocateDedicated(const VkDeviceSize kSize, const uint32_t kMemoryType);
+
+	// Points the allocation in the mapped memory, dedicated allocations pass nullptr to be mapped here.
+	// Memory is unmapped implicitly by vkFreeMemory
+	void MapAllocation(Allocation& allocation, void* kMapped) const;
+
+	VkMappedMemoryRange GetMappedRange(const Allocation& kAllocation, const VkDeviceSize kOffset, const VkDeviceSize kSize) const;
+
+public:
+	static MemoryAllocator& Instance();
+
+	Allocation Allocate(const VkMemoryRequirements& kRequirements, const uint32_t kMemoryType, const ResourceType kType);
+	void Free(Allocation& allocation);
+
+	// Only needed for non coherent memory, ranges are relative to the allocation
+	void Flush(const Allocation& kAllocation, const VkDeviceSize kOffset, const VkDeviceSize kSize) const;
+	void Invalidate(const Allocation& kAllocation, const VkDeviceSize kOffset, const VkDeviceSize kSize) const;
+
+	Statistics GetStatistics(const uint32_t kMemoryType) const;
+	Statistics GetStatistics() const;
+};
+
+template<>
+inline void DrawEditor<MemoryAllocator::Statistics>(const MemoryAllocator::Statistics& obj)
+{
+	ImGui::Columns(2);
+
+	ImGui::Text("_blockCount"); ImGui::NextColumn();
+	ImGui::Text("%u", obj._blockCount); ImGui::NextColumn();
+
+	ImGui::Text("_allocationCount"); ImGui::NextColumn();
+	ImGui::Text("%u", obj._allocationCount); ImGui::NextColumn();
+
+	ImGui::Text("_dedicatedCount"); ImGui::NextColumn();
+	ImGui::Text("%u", obj._dedicatedCount); ImGui::NextColumn();
+
+	ImGui::Text("_blockBytes"); ImGui::NextColumn();
+	ImGui::Text("%llu", static_cast<unsigned long long>(obj._blockBytes)); ImGui::NextColumn();
+
+	ImGui::Text("_usedBytes"); ImGui::NextColumn();
+	ImGui::Text("%llu", static_cast<unsigned long long>(obj._usedBytes)); ImGui::NextColumn();
+
+	ImGui::Text("_dedicatedBytes"); ImGui::NextColumn();
+	ImGui::Text("%llu", static_cast<unsigned long long>(obj._dedicatedBytes)); ImGui::NextColumn();
+
+	ImGui::Columns(1);
+}
+
+template<>
+inline void DrawEditor<MemoryAllocator>(const MemoryAllocator& obj)
+{
+	DrawEditor(obj.GetStatistics());
+
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+	{
+		const MemoryAllocator::Statistics kStatistics = obj.GetStatistics(i);
+		if (kStatistics._blockCount == 0 && kStatistics._dedicatedCount == 0)
+			continue;
+
+		if (ImGui::CollapsingHeader(("memory type " + std::to_string(i)).c_str()))
+		{
+			ImGui::Indent();
+			DrawEditor(kStatistics);
+			ImGui::Unindent();
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "ShaderReflection.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+// SPIR-V loaded once per content, shared by every material using it
+struct Shader
+{
+	uint64_t					_hash		= 0;
+	std::vector<uint32_t>		_code;
+	ShaderReflection			_reflection;	// done once per content, materials only merge it
+
+	// identifierSize is 0 without VK_EXT_shader_module_identifier
+	VkShaderModuleIdentifierEXT	_identifier{};
+
+	// Created on the first ShaderLibrary::GetModule, pipelines found by identifier never need it
+	VkShaderModule				_module		= VK_NULL_HANDLE;
+};
+
+// Caches the shaders by path and by content hash, so materials sharing a shader read and create it once
+class ShaderLibrary
+{
+	static ShaderLibrary* _sInstance;
+
+	std::unordered_map<std::string, const Shader*>			_paths;
+	std::unordered_map<uint64_t, std::unique_ptr<Shader>>	_shaders;
+
+	PFN_vkGetShaderModuleCreateInfoIdentifierEXT	_getIdentifier	= nullptr;
+
+	mutable std::mutex	_mutex;
+
+public:
+	ShaderLibrary();
+	~ShaderLibrary();
+
+	ShaderLibrary(const ShaderLibrary& kShaderLibrary) = delete;
+	ShaderLibrary& operator=(const ShaderLibrary& kShaderLibrary) = delete;
+
+private:
+	static VkShaderModuleCreateInfo GetCreateInfo(const Shader& kShader);
+
+public:
+	static ShaderLibrary& Instance();
+
+	// Thread safe, the shader lives as long as the library
+	const Shader&	Load(const std::string& kPath);
+	VkShaderModule	GetModule(const Shader& kShader);
+
+	size_t			ShaderCount() const;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "Span.h"
+
+// Interface of a SPIR-V module: the resources, push constants and vertex inputs it declares.
+// Only what the layouts need is read, the module is expected to be valid
+struct ShaderReflection
+{
+	struct Binding
+	{
+		uint32_t			_set		= 0;
+		uint32_t			_binding	= 0;
+		VkDescriptorType	_type		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uint32_t			_count		= 1;	// 0 for runtime arrays
+		uint32_t			_size		= 0;	// bytes of the block, only for buffers
+		VkShaderStageFlags	_stages		= 0;	// stages which access it, declared only is not enough
+	};
+
+	struct Input
+	{
+		uint32_t	_location	= 0;
+		VkFormat	_format		= VK_FORMAT_UNDEFINED;
+	};
+
+	VkShaderStageFlags	_stage	= 0;
+
+	std::vector<Binding>	_bindings;		// sorted by set then binding
+	VkPushConstantRange		_pushConstant{};	// size 0 without push constants
+	std::vector<Input>		_inputs;		// vertex shaders only, sorted by location, built-ins excluded
+
+	static ShaderReflection Reflect(ez::Span<const uint32_t> kCode);
+
+	// Bindings of every stage with their stage masks combined, push constants in a single range
+	static ShaderReflection Merge(ez::Span<const ShaderReflection* const> kStages);
+
+	const Binding* FindBinding(const uint32_t kSet, const uint32_t kBinding) const;
+	uint32_t SetCount() const;
+};
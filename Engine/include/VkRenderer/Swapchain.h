@@ -15,7 +15,7 @@ class FrameData
 public:
 	CommandBuffer		_commandBuffer;
 
-	VkFence				_fence				= VK_NULL_HANDLE;
+	uint64_t			_submitValue		= 0;	// graphics timeline value of the last submission
 	VkSemaphore			_presentComplete	= VK_NULL_HANDLE;
 	VkSemaphore			_renderComplete		= VK_NULL_HANDLE;
 
@@ -78,7 +78,7 @@ public:
 	Swapchain& operator=(const Swapchain& kSwapchain) = delete;
 
 private:
-	void Init(const Surface& kSurface, const GLFWWindowData* windowData);
+	void Init(const Surface& kSurface, const GLFWWindowData* windowData, const VkSwapchainKHR kOldSwapchain = VK_NULL_HANDLE);
 	void Clean();
 
 public:
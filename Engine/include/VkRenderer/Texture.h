@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 
 #include "ImageBuffer.h"
+#include "BindlessRegistry.h"
 
 #include <array>
 
@@ -25,6 +26,9 @@ public:
 	ImageBuffer			_image;
 	VkSampler			_sampler		= VK_NULL_HANDLE;
 
+	uint64_t			_uploadTicket	= 0;	// UploadBatcher ticket of the pixels
+	uint32_t			_bindlessIndex	= BindlessRegistry::INVALID_INDEX;	// in the array of the BindlessRegistry matching _image
+
 public:
 	Texture(const std::string kTexturePath, const Format kFormat = Format::RGBA);
 	Texture(const std::array<std::string, 6> kCubemapPath, const Format kFormat = Format::RGBA);
@@ -38,5 +42,8 @@ private:
 	VkFormat GetVkFormat(const Format kFormat) const;
 
 public:
+	// Drawing doesn't need to wait for it, the upload is submitted before the frame
+	bool IsUploaded() const;
+
 	const VkDescriptorImageInfo CreateDescriptorInfo() const;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+
+#include "Buffer.h"
+#include "GpuTimeline.h"
+
+// Linear allocator over one persistently mapped uniform buffer, split in a region per frame in flight.
+// Data written during a frame is never overwritten before the GPU is done with it, and is bound with dynamic offsets
+class UniformRing
+{
+public:
+	static constexpr uint32_t FRAME_COUNT = 3;
+
+private:
+	static UniformRing* _sInstance;
+
+public:
+	Buffer			_buffer;
+
+private:
+	VkDeviceSize	_frameSize	= 0;
+	VkDeviceSize	_alignment	= 0;	// minUniformBufferOffsetAlignment
+	uint32_t		_frame		= 0;
+	VkDeviceSize	_head		= 0;	// used bytes of the current frame
+
+	// Submissions which may read each region, tagged when the ring moves past it
+	std::array<GpuTimeline::Point, FRAME_COUNT>	_points{};
+
+public:
+	UniformRing(const VkDeviceSize kFrameSize);
+	~UniformRing();
+
+	UniformRing(const UniformRing& kUniformRing) = delete;
+	UniformRing& operator=(const UniformRing& kUniformRing) = delete;
+
+public:
+	static UniformRing& Instance();
+
+	// Moves to the region of the next frame, everything written in it FRAME_COUNT frames ago is dropped.
+	// Waits for the GPU to be done with the submissions of that frame, to be called after they are submitted
+	void BeginFrame();
+	// Flushes the region of the frame, to be called before submitting the frame
+	void EndFrame() const;
+
+	// Returns the dynamic offset of the data
+	uint32_t Write(const void* kData, const size_t kSize);
+
+	template<typename T>
+	uint32_t Write(const T& kValue);
+};
+
+#include "UniformRing.inl"
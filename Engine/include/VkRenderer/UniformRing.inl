@@ -0,0 +1,12 @@
+#pragma once
+
+#include <type_traits>
+
+#include "UniformRing.h"
+
+template<typename T>
+uint32_t UniformRing::Write(const T& kValue)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T has to be trivially copyable to be written in a buffer");
+	return Write(&kValue, sizeof(T));
+}
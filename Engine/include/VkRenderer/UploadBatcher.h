@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "Buffer.h"
+#include "ImageBuffer.h"
+#include "CommandBuffer.h"
+
+// Records the uploads in one command buffer of the transfer queue, submitted once per batch.
+// When the transfer queue is of another family, the ownership is released there and acquired on the graphics queue.
+// Uploads return a ticket to poll, the staging memory is kept until the GPU is done with it
+class UploadBatcher
+{
+public:
+	using Ticket = uint64_t;
+
+private:
+	static UploadBatcher* _sInstance;
+
+	enum class State
+	{
+		FREE,
+		RECORDING,
+		SUBMITTED
+	};
+
+	struct Batch
+	{
+		CommandBuffer		_transferCommands;
+		CommandBuffer		_graphicsCommands;	// acquires the ownership, not used when the queues share a family
+		uint64_t			_submitValue		= 0;	// timeline value of the last queue the batch goes through
+
+		std::vector<Buffer>	_stagingBuffers;
+		Ticket				_ticket				= 0;
+		State				_state				= State::FREE;
+
+		Batch();
+
+		Batch(const Batch& kBatch) = delete;
+		Batch& operator=(const Batch& kBatch) = delete;
+	};
+
+	std::vector<std::unique_ptr<Batch>>	_batches;
+	Batch*								_recording		= nullptr;
+	Ticket								_nextTicket		= 1;
+
+	mutable std::mutex					_mutex;
+
+public:
+	UploadBatcher();
+	~UploadBatcher();
+
+	UploadBatcher(const UploadBatcher& kUploadBatcher) = delete;
+	UploadBatcher& operator=(const UploadBatcher& kUploadBatcher) = delete;
+
+private:
+	static bool IsSameFamily();
+	// Queue whose timeline tells when a batch is done
+	static const Queue& GetLastQueue();
+
+	Batch&	GetRecordingBatch();
+	Buffer&	CreateStagingBuffer(Batch& batch, const size_t kSize);
+
+	void	SubmitRecording();
+	void	Poll();
+
+public:
+	static UploadBatcher& Instance();
+
+	// kBuffer has to be DEVICE_LOCAL, it can be used by the graphics queue once the batch is submitted
+	Ticket Upload(const Buffer& kBuffer, const void* kData, const size_t kSize, const size_t kOffset = 0);
+	// Fills the layers of kImage, kLayerSize bytes each, and leaves it in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	Ticket Upload(const ImageBuffer& kImage, ez::Span<const void* const> kLayers, const size_t kLayerSize);
+
+	// Submits the uploads recorded so far, has to be done before submitting a frame using them
+	void Submit();
+
+	// Submits and recycles the finished batches, once per frame
+	void Update();
+
+	bool IsComplete(const Ticket kTicket);
+	void Wait(const Ticket kTicket);
+};
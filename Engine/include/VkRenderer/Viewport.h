@@ -12,7 +12,7 @@ class Mesh;
 class Viewport
 {
 public:
-	VkFence					_fence				= VK_NULL_HANDLE;
+	uint64_t				_submitValue		= 0;	// graphics timeline value of the last submission
 
 	CommandBuffer			_commandBuffer;
 
@@ -40,7 +40,7 @@ void ImGuiSystem::Init(const GLFWWindowData* windowData, const Context& kContext
 	init_info.Device = kLogicalDevice._device;
 	init_info.QueueFamily = kLogicalDevice._graphicsQueue._indice; // SURE ?
 	init_info.Queue = kLogicalDevice._graphicsQueue._queue;
-	init_info.PipelineCache = VK_NULL_HANDLE;
+	init_info.PipelineCache = kLogicalDevice._pipelineCache;
 	init_info.DescriptorPool = kLogicalDevice._descriptorPool;
 	init_info.Allocator = kContext._allocator;
 	init_info.MinImageCount = kSwapchain._imageCount; // Sure ?
@@ -0,0 +1,151 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#define NOGDI
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace ez
+{
+	MappedFile::MappedFile(const std::string& kPath)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(kPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		_file = file;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			Clean();
+			return;
+		}
+
+		_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mapping == nullptr)
+		{
+			Clean();
+			return;
+		}
+
+		_data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+		if (_data == nullptr)
+		{
+			Clean();
+			return;
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+#else
+		_file = open(kPath.c_str(), O_RDONLY);
+		if (_file < 0)
+			return;
+
+		struct stat fileStat{};
+		if (fstat(_file, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			Clean();
+			return;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+		if (data == MAP_FAILED)
+		{
+			Clean();
+			return;
+		}
+
+		_data = data;
+		_size = static_cast<size_t>(fileStat.st_size);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Clean();
+	}
+
+	MappedFile::MappedFile(MappedFile&& mappedFile)
+		: _data{ mappedFile._data }, _size{ mappedFile._size }, _file{ mappedFile._file }
+#ifdef _WIN32
+		, _mapping{ mappedFile._mapping }
+#endif
+	{
+		mappedFile._data = nullptr;
+		mappedFile._size = 0;
+#ifdef _WIN32
+		mappedFile._file = nullptr;
+		mappedFile._mapping = nullptr;
+#else
+		mappedFile._file = -1;
+#endif
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& mappedFile)
+	{
+		Clean();
+
+		_data = mappedFile._data;
+		_size = mappedFile._size;
+		_file = mappedFile._file;
+
+		mappedFile._data = nullptr;
+		mappedFile._size = 0;
+#ifdef _WIN32
+		_mapping = mappedFile._mapping;
+
+		mappedFile._file = nullptr;
+		mappedFile._mapping = nullptr;
+#else
+		mappedFile._file = -1;
+#endif
+
+		return *this;
+	}
+
+	void MappedFile::Clean()
+	{
+#ifdef _WIN32
+		if (_data != nullptr)
+			UnmapViewOfFile(_data);
+		if (_mapping != nullptr)
+			CloseHandle(_mapping);
+		if (_file != nullptr)
+			CloseHandle(_file);
+
+		_mapping = nullptr;
+		_file = nullptr;
+#else
+		if (_data != nullptr)
+			munmap(const_cast<void*>(_data), _size);
+		if (_file >= 0)
+			close(_file);
+
+		_file = -1;
+#endif
+		_data = nullptr;
+		_size = 0;
+	}
+
+	bool MappedFile::IsOpen() const
+	{
+		return _data != nullptr;
+	}
+
+	const void* MappedFile::Data() const
+	{
+		return _data;
+	}
+
+	size_t MappedFile::Size() const
+	{
+		return _size;
+	}
+}
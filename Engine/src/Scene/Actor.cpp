@@ -1,12 +1,56 @@
 #include "Scene/Actor.h"
 
+#include "Core.h"
+
+#include <algorithm>
+#include <cmath>
+
 Actor::Actor(const Mesh& kMesh, const MaterialInstance& kMaterial)
 	: _mesh{ &kMesh }, _material{ &kMaterial }
 {
+	// The position and attribute streams only exist for the formats the mesh opted in to
+	ASSERT(kMesh._vertexFormats & Mesh::FormatBit(kMaterial._kMaterial->_vertexFormat), "mesh is not built with the vertex format of the material")
+}
+
+const Mesh& Actor::GetMesh() const
+{
+	return *_mesh;
 }
 
-void Actor::Draw(const CommandBuffer& commandBuffer) const
+const MaterialInstance* Actor::GetDrawable() const
 {
-	_material->Bind(commandBuffer);
-	_mesh->Draw(commandBuffer);
+	return _material->GetDrawable();
+}
+
+float Actor::GetDistance(const Camera& kCamera) const
+{
+	return glm::distance(Vec3(_transform.GetMatrix() * Vec4(_mesh->_boundsCenter, 1.f)), kCamera._pos);
+}
+
+size_t Actor::SelectLod(const Camera& kCamera, const float kViewportHeight) const
+{
+	const Mat4 kModel = _transform.GetMatrix();
+	const Vec3 kCenter = Vec3(kModel * Vec4(_mesh->_boundsCenter, 1.f));
+	const float kScale = std::max({ glm::length(Vec3(kModel[0])), glm::length(Vec3(kModel[1])), glm::length(Vec3(kModel[2])) });
+
+	// Distance to the closest point of the bounding sphere, the camera inside it gets the full mesh
+	const float kDistance = glm::distance(kCenter, kCamera._pos) - _mesh->_boundsRadius * kScale;
+	if (kDistance <= kCamera._near)
+		return 0;
+
+	const float kPixelsPerUnit = kViewportHeight / (2.f * kDistance * std::tan(glm::radians(kCamera._fov) * 0.5f));
+	return _mesh->SelectLod(kPixelsPerUnit * kScale);
+}
+
+void Actor::Draw(CommandRecorder& recorder, const DynamicOffsets& kDynamicOffsets, const size_t kLod) const
+{
+	const MaterialInstance* kMaterial = _material->GetDrawable();
+	if (kMaterial == nullptr)
+		return;
+
+	kMaterial->Bind(recorder, kDynamicOffsets);
+	// The quantized positions of the mesh are brought back to mesh units by the model matrix, the shaders don't know about it
+	const Vertex::Format kFormat = kMaterial->_kMaterial->_vertexFormat;
+	kMaterial->Push(recorder, { _transform.GetMatrix() * _mesh->GetDequantization(kFormat), kMaterial->_parameters, kMaterial->_materialIndex });
+	_mesh->Draw(recorder, kFormat, kMaterial->_kMaterial->_vertexDataFlags, kLod);
 }
\ No newline at end of file
@@ -1,12 +1,12 @@
 #include "Scene/Camera.h"
 
 Camera::Camera(const float fov, const float near, const float far)
-	: _fov{ fov }, _near{ near }, _far{ far }, _ubo{ sizeof(Mat4) * 2 + sizeof(Vec3), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT }
+	: _fov{ fov }, _near{ near }, _far{ far }
 {
 	Update();
 }
 
-void Camera::Update() const
+void Camera::Update()
 {
 	Vec3 cameraDir = _pos + glm::rotate(_rot, Vec3(0, 0, 1));
 	Vec3 cameraUp = glm::rotate(_rot, Vec3(0, 1, 0));
@@ -15,8 +15,13 @@ void Camera::Update() const
 	Mat4 proj = glm::perspective(glm::radians(_fov), (16.f / 9.f), _near, _far);
 	proj[1][1] *= -1;
 
-	Mat4 data[]{ view, proj };
+	struct
+	{
+		Mat4 _view;
+		Mat4 _proj;
+		Vec3 _pos;
+	} data{ view, proj, _pos };
+	static_assert(sizeof(data) >= UBO_SIZE, "camera data doesn't match UBO_SIZE");
 
-	_ubo.Map(&data, sizeof(Mat4) * 2);
-	_ubo.Map((void*)&_pos, sizeof(Vec3), sizeof(Mat4) * 2);
+	_uboOffset = UniformRing::Instance().Write(&data, UBO_SIZE);
 }
\ No newline at end of file
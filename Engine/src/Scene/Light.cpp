@@ -1,10 +1,16 @@
 #include "Scene/Light.h"
 
 Light::Light(const Vec3& pos, const float intensity, const Vec3& color, const float range)
-	: _pos{ pos }, _intensity{ intensity}, _color{ color },
-		_range{ range }, _ubo{ sizeof(float) * 8, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT }
+	: _pos{ pos }, _intensity{ intensity}, _color{ color }, _range{ range }
 {
-	float data[]{ _pos.x, _pos.y, _pos.z, _intensity, 
-		_color.x, _color.y, _color.z, _range,};
-	_ubo.Map(&data, sizeof(float) * 8);
+	Update();
+}
+
+void Light::Update()
+{
+	const float kData[]{ _pos.x, _pos.y, _pos.z, _intensity, 
+		_color.x, _color.y, _color.z, _range };
+	static_assert(sizeof(kData) == UBO_SIZE, "light data doesn't match UBO_SIZE");
+
+	_uboOffset = UniformRing::Instance().Write(kData, UBO_SIZE);
 }
\ No newline at end of file
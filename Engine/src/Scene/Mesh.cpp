@@ -1,83 +1,152 @@
 #include "Scene/Mesh.h"
 
-#include <unordered_map>
+#include <filesystem>
+#include <cstring>
+#include <algorithm>
 
 #include "tiny_obj_loader.h"
 #include "Core.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Scene/VertexWelder.h"
+#include "Scene/MeshOptimizer.h"
+#include "Scene/MeshSimplifier.h"
+#include "VkRenderer/UploadBatcher.h"
 
-Mesh::Mesh(const std::string kPath)
+namespace
 {
-	ASSERT(!kPath.empty(), "kPath is empty")
+	// Binary cache written next to the source mesh, holding the final vertex/index arrays.
+	// Bump MESH_CACHE_VERSION whenever the import output or the Vertex layout changes.
+	constexpr char			MESH_CACHE_MAGIC[4]		= { 'E', 'Z', 'M', 'C' };
+	constexpr uint32_t		MESH_CACHE_VERSION		= 4;
+	constexpr const char*	MESH_CACHE_EXTENSION	= ".meshcache";
 
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
+	struct MeshCacheHeader
+	{
+		char		_magic[4];
+		uint32_t	_version;
+		uint32_t	_vertexFlags;
+		uint32_t	_importFlags;
+		uint32_t	_vertexStride;
+		uint64_t	_vertexCount;
+		uint64_t	_indexCount;
+		uint32_t	_lodCount;		// Mesh::Lod array follows the indices
+		float		_boundsCenter[3];
+		float		_boundsRadius;
+		uint32_t	_meshletCount;	// then the meshlets, their vertices and their triangles
+		uint32_t	_meshletVertexCount;
+		uint32_t	_meshletTriangleCount;
+	};
 
-	bool loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, kPath.c_str(), nullptr, false);
-	ASSERT(loaded, "Load obj " + kPath + "failed. Warn: " + warn + "; Err: " + err)
+	constexpr uint32_t MESH_VERTEX_FLAGS = Vertex::POSITION | Vertex::UV | Vertex::NORMAL | Vertex::TANGENT;
 
-	std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-	for (const auto& shape : shapes) 
+	bool IsCacheUpToDate(const std::string& kSourcePath, const std::string& kCachePath)
 	{
-		size_t indexOffset = 0;
-		for (size_t i = 0; i < shape.mesh.num_face_vertices.size(); ++i)
+		std::error_code error;
+		const auto cacheTime = std::filesystem::last_write_time(kCachePath, error);
+		if (error)
+			return false;
+
+		const auto sourceTime = std::filesystem::last_write_time(kSourcePath, error);
+		if (error) // source is gone, the cache is all we have
+			return true;
+
+		return cacheTime >= sourceTime;
+	}
+
+	// Faces handled by a single import task, big enough to amortize the local dedupe
+	constexpr size_t IMPORT_FACES_PER_CHUNK = 1 << 16;
+
+	// Each LOD aims at this ratio of the triangles of the previous one, and is dropped if it can't get below LOD_MIN_REDUCTION
+	constexpr float LOD_REDUCTION		= 0.5f;
+	constexpr float LOD_MIN_REDUCTION	= 0.9f;
+	// Largest simplification error allowed, relative to the bounding radius
+	constexpr float LOD_MAX_ERROR		= 0.1f;
+
+	struct ImportChunk
+	{
+		size_t					_shape			= 0;
+		size_t					_faceBegin		= 0;
+		size_t					_faceEnd		= 0;
+		size_t					_indexOffset	= 0;	// first index of the chunk in the shape
+		size_t					_outputOffset	= 0;	// first index of the chunk in the mesh
+		size_t					_indexCount		= 0;
+
+		bool					_hasPolygons	= false;
+
+		std::vector<Vertex>		_vertices;				// unique in the chunk, by first use
+		std::vector<uint32_t>	_indices;				// into _vertices
+		std::vector<glm::vec3>	_tangents;				// of each index, summed by the merge pass in face order
+		std::vector<uint32_t>	_remap;					// _vertices to mesh vertices
+	};
+
+	void ImportChunkVertices(const tinyobj::attrib_t& kAttrib, const std::vector<tinyobj::shape_t>& kShapes, ImportChunk& chunk)
+	{
+		const tinyobj::shape_t& kShape = kShapes[chunk._shape];
+
+		// Every corner can be a new vertex, sizing for it means the table never grows
+		VertexWelder welder(chunk._vertices, chunk._indexCount);
+		chunk._indices.reserve(chunk._indexCount);
+		chunk._tangents.reserve(chunk._indexCount);
+
+		size_t indexOffset = chunk._indexOffset;
+		for (size_t i = chunk._faceBegin; i < chunk._faceEnd; ++i)
 		{
-			size_t fv = shape.mesh.num_face_vertices[i];
+			size_t fv = kShape.mesh.num_face_vertices[i];
 			if(fv > 3)
-				LOG(ez::WARNING, "Mesh " + kPath + " have a face with more than 3 vertices, tangent might be wrong")
+				chunk._hasPolygons = true;
 
 			for (size_t j = 0; j < fv; ++j)
 			{
 				Vertex vertex{};
-				tinyobj::index_t idx = shape.mesh.indices[indexOffset + j];
+				tinyobj::index_t idx = kShape.mesh.indices[indexOffset + j];
 
 				vertex.pos = {
-					attrib.vertices[3 * idx.vertex_index + 0],
-					attrib.vertices[3 * idx.vertex_index + 1],
-					attrib.vertices[3 * idx.vertex_index + 2]
+					kAttrib.vertices[3 * idx.vertex_index + 0],
+					kAttrib.vertices[3 * idx.vertex_index + 1],
+					kAttrib.vertices[3 * idx.vertex_index + 2]
 				};
 
 				vertex.uv = {
-					attrib.texcoords[2 * idx.texcoord_index + 0],
-					1.f - attrib.texcoords[2 * idx.texcoord_index + 1]
+					kAttrib.texcoords[2 * idx.texcoord_index + 0],
+					1.f - kAttrib.texcoords[2 * idx.texcoord_index + 1]
 				};
 
 				vertex.normal = {
-					attrib.normals[3 * idx.normal_index + 0],
-					attrib.normals[3 * idx.normal_index + 1],
-					attrib.normals[3 * idx.normal_index + 2]
+					kAttrib.normals[3 * idx.normal_index + 0],
+					kAttrib.normals[3 * idx.normal_index + 1],
+					kAttrib.normals[3 * idx.normal_index + 2]
 				};
 
 				// Shortcuts for vertices
 				glm::vec3 v0 = {
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 0].vertex_index + 0],
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 0].vertex_index + 1],
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 0].vertex_index + 2]
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 0].vertex_index + 0],
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 0].vertex_index + 1],
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 0].vertex_index + 2]
 				};
 				glm::vec3 v1 = {
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 1].vertex_index + 0],
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 1].vertex_index + 1],
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 1].vertex_index + 2]
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 1].vertex_index + 0],
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 1].vertex_index + 1],
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 1].vertex_index + 2]
 				};
 				glm::vec3 v2 = {
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 2].vertex_index + 0],
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 2].vertex_index + 1],
-					attrib.vertices[3 * shape.mesh.indices[indexOffset + 2].vertex_index + 2]
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 2].vertex_index + 0],
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 2].vertex_index + 1],
+					kAttrib.vertices[3 * kShape.mesh.indices[indexOffset + 2].vertex_index + 2]
 				};
 
 				// Shortcuts for UVs
 				glm::vec2 uv0 = {
-					attrib.texcoords[2 * shape.mesh.indices[indexOffset + 0].texcoord_index + 0],
-					1.f - attrib.texcoords[2 * shape.mesh.indices[indexOffset + 0].texcoord_index + 1]
+					kAttrib.texcoords[2 * kShape.mesh.indices[indexOffset + 0].texcoord_index + 0],
+					1.f - kAttrib.texcoords[2 * kShape.mesh.indices[indexOffset + 0].texcoord_index + 1]
 				};
 				glm::vec2 uv1 = {
-					attrib.texcoords[2 * shape.mesh.indices[indexOffset + 1].texcoord_index + 0],
-					1.f - attrib.texcoords[2 * shape.mesh.indices[indexOffset + 1].texcoord_index + 1]
+					kAttrib.texcoords[2 * kShape.mesh.indices[indexOffset + 1].texcoord_index + 0],
+					1.f - kAttrib.texcoords[2 * kShape.mesh.indices[indexOffset + 1].texcoord_index + 1]
 				};
 				glm::vec2 uv2 = {
-					attrib.texcoords[2 * shape.mesh.indices[indexOffset + 2].texcoord_index + 0],
-					1.f - attrib.texcoords[2 * shape.mesh.indices[indexOffset + 2].texcoord_index + 1]
+					kAttrib.texcoords[2 * kShape.mesh.indices[indexOffset + 2].texcoord_index + 0],
+					1.f - kAttrib.texcoords[2 * kShape.mesh.indices[indexOffset + 2].texcoord_index + 1]
 				};
 
 				// Edges of the triangle : position delta
@@ -93,39 +162,438 @@ Mesh::Mesh(const std::string kPath)
 
 				vertex.tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y)*r;
 				
-				if (uniqueVertices.count(vertex) == 0) {
-					uniqueVertices[vertex] = static_cast<uint32_t>(_vertices.size());
-					_vertices.push_back(vertex);
-				}
-				else
-				{
-					_vertices[uniqueVertices[vertex]].tangent += vertex.tangent;
-				}
-
-				_indices.push_back(uniqueVertices[vertex]);
+				// Summed once every chunk is merged, float additions in another order wouldn't give the same tangents
+				chunk._indices.push_back(welder.Weld(vertex).first);
+				chunk._tangents.push_back(vertex.tangent);
 			}
 			indexOffset += fv;
 		}
 	}
 
+	// Creates a device local buffer filled by the UploadBatcher, returns the ticket of the upload
+	UploadBatcher::Ticket CreateDeviceBuffer(Buffer& buffer, const VkBufferUsageFlags kUsage, const void* kData, const size_t kSize)
+	{
+		Buffer deviceBuffer(kSize, kUsage, Buffer::MemoryUsage::DEVICE_LOCAL);
+		buffer = std::move(deviceBuffer);
+
+		return UploadBatcher::Instance().Upload(buffer, kData, kSize);
+	}
+
+	// Converts the imported vertices in the streams of one format
+	template<typename Position, typename Attributes, typename... PositionArgs>
+	UploadBatcher::Ticket CreateStreams(Mesh::VertexStreams& streams, const Vertex* kVertices, const size_t kVertexCount, const PositionArgs&... kPositionArgs)
+	{
+		std::vector<Position> positions(kVertexCount);
+		std::vector<Attributes> attributes(kVertexCount);
+		for (size_t i = 0; i < kVertexCount; ++i)
+		{
+			positions[i] = Position(kVertices[i], kPositionArgs...);
+			attributes[i] = Attributes(kVertices[i]);
+		}
+
+		CreateDeviceBuffer(streams._positions, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, positions.data(), sizeof(Position) * kVertexCount);
+		return CreateDeviceBuffer(streams._attributes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, attributes.data(), sizeof(Attributes) * kVertexCount);
+	}
+
+	void RemapChunkIndices(const ImportChunk& kChunk, std::vector<uint32_t>& indices)
+	{
+		for (size_t i = 0; i < kChunk._indices.size(); ++i)
+			indices[kChunk._outputOffset + i] = kChunk._remap[kChunk._indices[i]];
+	}
+}
+
+Mesh::Mesh(const std::string kPath, const int kImportFlags, const int kVertexFormats)
+	: _importFlags{ kImportFlags }, _vertexFormats{ kVertexFormats }
+{
+	ASSERT(!kPath.empty(), "kPath is empty")
+	ASSERT(kVertexFormats != 0, "mesh is built without any vertex format")
+
+	const std::string cachePath = kPath + MESH_CACHE_EXTENSION;
+	if (IsCacheUpToDate(kPath, cachePath) && LoadCache(cachePath))
+		return;
+
+	Import(kPath);
+	Optimize(kPath);
+	ComputeBounds();
+	GenerateLods(kPath);
+	GenerateMeshlets(kPath);
+	SaveCache(cachePath);
+
+	Upload(_vertices.data(), _vertices.size(), _indices.data(), _indices.size());
+	UploadMeshlets();
+}
+
+void Mesh::Import(const std::string& kPath)
+{
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string warn, err;
+
+	bool loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, kPath.c_str(), nullptr, false);
+	ASSERT(loaded, "Load obj " + kPath + "failed. Warn: " + warn + "; Err: " + err)
+
+	// Split every shape in ranges of faces, in file order, so the merge below can keep
+	// the vertex ordering of a sequential import whatever the number of workers
+	std::vector<ImportChunk> chunks;
+	size_t totalIndexCount = 0;
+	for (size_t s = 0; s < shapes.size(); ++s)
+	{
+		const tinyobj::mesh_t& kMesh = shapes[s].mesh;
+
+		size_t indexOffset = 0;
+		for (size_t faceBegin = 0; faceBegin < kMesh.num_face_vertices.size(); faceBegin += IMPORT_FACES_PER_CHUNK)
+		{
+			ImportChunk chunk{};
+			chunk._shape = s;
+			chunk._faceBegin = faceBegin;
+			chunk._faceEnd = std::min(faceBegin + IMPORT_FACES_PER_CHUNK, kMesh.num_face_vertices.size());
+			chunk._indexOffset = indexOffset;
+			chunk._outputOffset = totalIndexCount;
+
+			for (size_t i = chunk._faceBegin; i < chunk._faceEnd; ++i)
+				indexOffset += kMesh.num_face_vertices[i];
+
+			chunk._indexCount = indexOffset - chunk._indexOffset;
+			totalIndexCount += chunk._indexCount;
+			chunks.push_back(std::move(chunk));
+		}
+	}
+
+	if (chunks.size() == 1)
+		ImportChunkVertices(attrib, shapes, chunks.front());
+	else
+	{
+		std::vector<std::future<void>> tasks;
+		tasks.reserve(chunks.size());
+		for (ImportChunk& chunk : chunks)
+			tasks.push_back(ez::ThreadPool::Instance().Enqueue([&attrib, &shapes, &chunk]() { ImportChunkVertices(attrib, shapes, chunk); }));
+
+		for (std::future<void>& task : tasks)
+			task.get();
+	}
+
+	bool hasPolygons = false;
+	for (const ImportChunk& kChunk : chunks)
+		hasPolygons |= kChunk._hasPolygons;
+
+	if (hasPolygons)
+		LOG(ez::WARNING, "Mesh " + kPath + " have a face with more than 3 vertices, tangent might be wrong")
+
+	// Merge pass: chunks are walked in order and each chunk lists its vertices by first use,
+	// so a vertex gets the same index it would have had with a single thread
+	size_t chunkVertexCount = 0;
+	for (const ImportChunk& kChunk : chunks)
+		chunkVertexCount += kChunk._vertices.size();
+
+	VertexWelder welder(_vertices, chunkVertexCount);
+	uint32_t nextVertex = 0;
+	for (ImportChunk& chunk : chunks)
+	{
+		chunk._remap.resize(chunk._vertices.size());
+		for (size_t i = 0; i < chunk._vertices.size(); ++i)
+			chunk._remap[i] = welder.Weld(chunk._vertices[i]).first;
+
+		// Tangents are summed corner by corner in face order, the same additions as a single thread.
+		// Indices are given by first use, a corner using the next one is the first use of its vertex
+		for (size_t i = 0; i < chunk._indices.size(); ++i)
+		{
+			const uint32_t kIndex = chunk._remap[chunk._indices[i]];
+			if (kIndex == nextVertex)
+			{
+				_vertices[kIndex].tangent = chunk._tangents[i];
+				++nextVertex;
+			}
+			else
+				_vertices[kIndex].tangent += chunk._tangents[i];
+		}
+
+		// Local vertices are not needed anymore, release them early to lower the peak memory
+		chunk._vertices = std::vector<Vertex>();
+		chunk._tangents = std::vector<glm::vec3>();
+	}
+
+	_indices.resize(totalIndexCount);
+	if (chunks.size() == 1)
+		RemapChunkIndices(chunks.front(), _indices);
+	else
+	{
+		std::vector<std::future<void>> tasks;
+		tasks.reserve(chunks.size());
+		for (const ImportChunk& kChunk : chunks)
+			tasks.push_back(ez::ThreadPool::Instance().Enqueue([this, &kChunk]() { RemapChunkIndices(kChunk, _indices); }));
+
+		for (std::future<void>& task : tasks)
+			task.get();
+	}
+}
+
+void Mesh::Optimize(const std::string& kPath)
+{
+	if (_importFlags == 0 || _indices.empty())
+		return;
+
+	const VertexCacheStatistics kBefore = AnalyzeVertexCache(_indices, _vertices.size());
+
+	if (_importFlags & ImportFlag::OPTIMIZE_VERTEX_CACHE)
+		OptimizeVertexCache(_indices, _vertices.size());
+
+	// Works on the clusters produced by the vertex cache optimization
+	if (_importFlags & ImportFlag::OPTIMIZE_OVERDRAW)
+		OptimizeOverdraw(_indices, _vertices);
+
+	if (_importFlags & ImportFlag::OPTIMIZE_VERTEX_FETCH)
+		OptimizeVertexFetch(_vertices, _indices);
+
+	const VertexCacheStatistics kAfter = AnalyzeVertexCache(_indices, _vertices.size());
+
+	LOG(ez::INFO, "Mesh " + kPath + " optimized, ACMR " + std::to_string(kBefore._acmr) + " -> " + std::to_string(kAfter._acmr)
+		+ ", ATVR " + std::to_string(kBefore._atvr) + " -> " + std::to_string(kAfter._atvr))
+}
+
+void Mesh::ComputeBounds()
+{
+	if (_vertices.empty())
+		return;
+
+	Vec3 min = _vertices.front().pos;
+	Vec3 max = _vertices.front().pos;
+	for (const Vertex& kVertex : _vertices)
 	{
-		Buffer indicesBuf(sizeof(_indices[0]) * _indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
-		_indicesBuffer = std::move(indicesBuf);
-		_indicesBuffer.Map(_indices.data(), sizeof(_indices[0]) * _indices.size());
+		min = glm::min(min, kVertex.pos);
+		max = glm::max(max, kVertex.pos);
 	}
 
+	_boundsCenter = (min + max) * 0.5f;
+	_boundsRadius = 0.f;
+	for (const Vertex& kVertex : _vertices)
+		_boundsRadius = std::max(_boundsRadius, glm::distance(_boundsCenter, kVertex.pos));
+}
+
+void Mesh::GenerateLods(const std::string& kPath)
+{
+	_lods = { { 0, static_cast<uint32_t>(_indices.size()), 0.f } };
+	if (!(_importFlags & ImportFlag::GENERATE_LODS) || _indices.empty())
+		return;
+
+	// Each LOD is simplified from the previous one, which is cheaper and keeps the chain coherent
+	std::vector<uint32_t> lodIndices = _indices;
+	while (_lods.size() < MAX_LOD_COUNT)
 	{
-		Buffer verticesBuffer(sizeof(_vertices[0]) * _vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-		_verticesBuffer = std::move(verticesBuffer);
-		_verticesBuffer.Map(_vertices.data(), sizeof(_vertices[0]) * _vertices.size());
+		const size_t kTargetIndexCount = static_cast<size_t>(lodIndices.size() / 3 * LOD_REDUCTION) * 3;
+
+		float error = 0.f;
+		std::vector<uint32_t> simplified = SimplifyMesh(lodIndices, _vertices, kTargetIndexCount, LOD_MAX_ERROR * _boundsRadius, &error);
+		if (simplified.empty() || simplified.size() > lodIndices.size() * LOD_MIN_REDUCTION)
+			break;
+
+		if (_importFlags & ImportFlag::OPTIMIZE_VERTEX_CACHE)
+			OptimizeVertexCache(simplified, _vertices.size());
+
+		// Errors are kept increasing so the selection can stop at the first LOD too coarse
+		error = std::max(error, _lods.back()._error);
+		_lods.push_back({ static_cast<uint32_t>(_indices.size()), static_cast<uint32_t>(simplified.size()), error });
+		_indices.insert(_indices.end(), simplified.begin(), simplified.end());
+
+		lodIndices = std::move(simplified);
 	}
+
+	std::string lodCounts;
+	for (const Lod& kLod : _lods)
+		lodCounts += " " + std::to_string(kLod._indexCount / 3);
+
+	LOG(ez::INFO, "Mesh " + kPath + " has " + std::to_string(_lods.size()) + " LODs, triangles:" + lodCounts)
+}
+
+void Mesh::GenerateMeshlets(const std::string& kPath)
+{
+	if (!(_importFlags & ImportFlag::BUILD_MESHLETS) || _indices.empty())
+		return;
+
+	const std::vector<uint32_t> kLodIndices(_indices.begin(), _indices.begin() + _lods.front()._indexCount);
+	_meshletData = BuildMeshlets(kLodIndices, _vertices);
+
+	LOG(ez::INFO, "Mesh " + kPath + " split in " + std::to_string(_meshletData._meshlets.size()) + " meshlets")
+}
+
+bool Mesh::LoadCache(const std::string& kCachePath)
+{
+	ez::MappedFile file(kCachePath);
+	if (!file.IsOpen() || file.Size() < sizeof(MeshCacheHeader))
+		return false;
+
+	const MeshCacheHeader* header = static_cast<const MeshCacheHeader*>(file.Data());
+	if (memcmp(header->_magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0
+		|| header->_version != MESH_CACHE_VERSION
+		|| header->_vertexFlags != MESH_VERTEX_FLAGS
+		|| header->_importFlags != static_cast<uint32_t>(_importFlags)
+		|| header->_vertexStride != sizeof(Vertex))
+	{
+		LOG(ez::INFO, "Mesh cache " + kCachePath + " is outdated, reimporting")
+		return false;
+	}
+
+	const size_t verticesSize = sizeof(Vertex) * header->_vertexCount;
+	const size_t indicesSize = sizeof(uint32_t) * header->_indexCount;
+	const size_t lodsSize = sizeof(Lod) * header->_lodCount;
+	const size_t meshletsSize = sizeof(Meshlet) * header->_meshletCount + sizeof(uint32_t) * header->_meshletVertexCount
+								+ sizeof(uint8_t) * 3 * header->_meshletTriangleCount;
+	if (header->_vertexCount == 0 || header->_indexCount == 0 || header->_lodCount == 0
+		|| file.Size() < sizeof(MeshCacheHeader) + verticesSize + indicesSize + lodsSize + meshletsSize)
+	{
+		LOG(ez::WARNING, "Mesh cache " + kCachePath + " is truncated, reimporting")
+		return false;
+	}
+
+	const uint8_t* data = static_cast<const uint8_t*>(file.Data()) + sizeof(MeshCacheHeader);
+
+	const Lod* kLods = reinterpret_cast<const Lod*>(data + verticesSize + indicesSize);
+	_lods.assign(kLods, kLods + header->_lodCount);
+	_boundsCenter = { header->_boundsCenter[0], header->_boundsCenter[1], header->_boundsCenter[2] };
+	_boundsRadius = header->_boundsRadius;
+
+	const Meshlet* kMeshlets = reinterpret_cast<const Meshlet*>(data + verticesSize + indicesSize + lodsSize);
+	const uint32_t* kMeshletVertices = reinterpret_cast<const uint32_t*>(kMeshlets + header->_meshletCount);
+	const uint8_t* kMeshletTriangles = reinterpret_cast<const uint8_t*>(kMeshletVertices + header->_meshletVertexCount);
+	_meshletData._meshlets.assign(kMeshlets, kMeshlets + header->_meshletCount);
+	_meshletData._vertices.assign(kMeshletVertices, kMeshletVertices + header->_meshletVertexCount);
+	_meshletData._triangles.assign(kMeshletTriangles, kMeshletTriangles + 3 * header->_meshletTriangleCount);
+
+	Upload(reinterpret_cast<const Vertex*>(data), header->_vertexCount,
+			reinterpret_cast<const uint32_t*>(data + verticesSize), header->_indexCount);
+	UploadMeshlets();
+
+	return true;
 }
 
-void Mesh::Draw(const CommandBuffer& commandBuffer) const
+void Mesh::SaveCache(const std::string& kCachePath) const
 {
-	vkCmdBindIndexBuffer(commandBuffer, _indicesBuffer, 0, VK_INDEX_TYPE_UINT32);
-	VkDeviceSize offset[]{ 0 };
-	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &_verticesBuffer._buffer, offset);
+	std::ofstream file(kCachePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG(ez::WARNING, "Failed to write mesh cache " + kCachePath)
+		return;
+	}
+
+	MeshCacheHeader header{};
+	memcpy(header._magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header._version = MESH_CACHE_VERSION;
+	header._vertexFlags = MESH_VERTEX_FLAGS;
+	header._importFlags = static_cast<uint32_t>(_importFlags);
+	header._vertexStride = sizeof(Vertex);
+	header._vertexCount = _vertices.size();
+	header._indexCount = _indices.size();
+	header._lodCount = static_cast<uint32_t>(_lods.size());
+	header._boundsCenter[0] = _boundsCenter.x;
+	header._boundsCenter[1] = _boundsCenter.y;
+	header._boundsCenter[2] = _boundsCenter.z;
+	header._boundsRadius = _boundsRadius;
+	header._meshletCount = static_cast<uint32_t>(_meshletData._meshlets.size());
+	header._meshletVertexCount = static_cast<uint32_t>(_meshletData._vertices.size());
+	header._meshletTriangleCount = static_cast<uint32_t>(_meshletData._triangles.size() / 3);
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(_vertices.data()), sizeof(Vertex) * _vertices.size());
+	file.write(reinterpret_cast<const char*>(_indices.data()), sizeof(uint32_t) * _indices.size());
+	file.write(reinterpret_cast<const char*>(_lods.data()), sizeof(Lod) * _lods.size());
+	file.write(reinterpret_cast<const char*>(_meshletData._meshlets.data()), sizeof(Meshlet) * _meshletData._meshlets.size());
+	file.write(reinterpret_cast<const char*>(_meshletData._vertices.data()), sizeof(uint32_t) * _meshletData._vertices.size());
+	file.write(reinterpret_cast<const char*>(_meshletData._triangles.data()), sizeof(uint8_t) * _meshletData._triangles.size());
+}
+
+void Mesh::Upload(const Vertex* kVertices, const size_t kVertexCount, const uint32_t* kIndices, const size_t kIndexCount)
+{
+	ASSERT(kVertices != nullptr && kVertexCount != 0u, "no vertices to upload")
+	ASSERT(kIndices != nullptr && kIndexCount != 0u, "no indices to upload")
+
+	_indexCount = static_cast<uint32_t>(kIndexCount);
+
+	// Every buffer lands in the same batch, the last ticket covers them all
+	_uploadTicket = CreateDeviceBuffer(_indicesBuffer, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, kIndices, sizeof(uint32_t) * kIndexCount);
+
+	if (_vertexFormats & FormatBit(Vertex::Format::FLOAT))
+		_uploadTicket = CreateStreams<VertexPosition, VertexAttributes>(_verticesBuffers[static_cast<size_t>(Vertex::Format::FLOAT)], kVertices, kVertexCount);
+	if (_vertexFormats & FormatBit(Vertex::Format::COMPACT))
+	{
+		Vec3 min = kVertices[0].pos;
+		Vec3 max = kVertices[0].pos;
+		for (size_t i = 1; i < kVertexCount; ++i)
+		{
+			min = glm::min(min, kVertices[i].pos);
+			max = glm::max(max, kVertices[i].pos);
+		}
+
+		const Vec3 kExtent = (max - min) * 0.5f;
+		_quantizationOffset = (min + max) * 0.5f;
+		_quantizationScale = std::max({ kExtent.x, kExtent.y, kExtent.z });
+		// Every vertex at the same place, any scale works
+		if (_quantizationScale == 0.f)
+			_quantizationScale = 1.f;
+
+		_uploadTicket = CreateStreams<CompactVertexPosition, CompactVertexAttributes>(_verticesBuffers[static_cast<size_t>(Vertex::Format::COMPACT)],
+							kVertices, kVertexCount, _quantizationOffset, _quantizationScale);
+	}
+}
+
+void Mesh::UploadMeshlets()
+{
+	if (_meshletData._meshlets.empty())
+		return;
+
+	const size_t kMeshletsSize = sizeof(Meshlet) * _meshletData._meshlets.size();
+	const size_t kVerticesSize = sizeof(uint32_t) * _meshletData._vertices.size();
+	const size_t kTrianglesSize = sizeof(uint8_t) * _meshletData._triangles.size();
+
+	_meshletVerticesOffset = kMeshletsSize;
+	_meshletTrianglesOffset = kMeshletsSize + kVerticesSize;
+
+	// Storage buffers are read by 4 bytes words
+	const VkDeviceSize kSize = (_meshletTrianglesOffset + kTrianglesSize + 3) & ~VkDeviceSize(3);
+
+	std::vector<uint8_t> data(kSize, 0);
+	memcpy(data.data(), _meshletData._meshlets.data(), kMeshletsSize);
+	memcpy(data.data() + _meshletVerticesOffset, _meshletData._vertices.data(), kVerticesSize);
+	memcpy(data.data() + _meshletTrianglesOffset, _meshletData._triangles.data(), kTrianglesSize);
+
+	_uploadTicket = CreateDeviceBuffer(_meshletsBuffer, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, data.data(), data.size());
+}
+
+Mat4 Mesh::GetDequantization(const Vertex::Format kFormat) const
+{
+	if (kFormat != Vertex::Format::COMPACT)
+		return Mat4(1.f);
+
+	return glm::translate(Mat4(1.f), _quantizationOffset) * glm::scale(Mat4(1.f), Vec3(_quantizationScale));
+}
+
+bool Mesh::IsUploaded() const
+{
+	return UploadBatcher::Instance().IsComplete(_uploadTicket);
+}
+
+size_t Mesh::SelectLod(const float kPixelsPerUnit) const
+{
+	size_t lod = 0;
+	while (lod + 1 < _lods.size() && _lods[lod + 1]._error * kPixelsPerUnit <= LOD_PIXEL_ERROR)
+		lod++;
+
+	return lod;
+}
+
+void Mesh::Draw(CommandRecorder& recorder, const Vertex::Format kFormat, const int kVertexDataFlags, const size_t kLod) const
+{
+	ASSERT(kFormat != Vertex::Format::COUNT, "kFormat is not a vertex format")
+	ASSERT(_vertexFormats & FormatBit(kFormat), "mesh is not built with the vertex format of the material")
+	ASSERT(kLod < _lods.size(), "kLod is out of range")
+
+	recorder.BindIndexBuffer(_indicesBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	const VertexStreams& kStreams = _verticesBuffers[static_cast<size_t>(kFormat)];
+	if (kVertexDataFlags & Vertex::POSITION)
+		recorder.BindVertexBuffer(Vertex::POSITION_STREAM, kStreams._positions._buffer, 0);
+	if (kVertexDataFlags & Vertex::ATTRIBUTE_FLAGS)
+		recorder.BindVertexBuffer(Vertex::ATTRIBUTE_STREAM, kStreams._attributes._buffer, 0);
 
-	vkCmdDrawIndexed(commandBuffer, _indices.size(), 1, 0, 0, 0);
+	const CommandBuffer& kCommandBuffer = recorder;
+	vkCmdDrawIndexed(kCommandBuffer, _lods[kLod]._indexCount, 1, _lods[kLod]._indexOffset, 0, 0);
 }
@@ -0,0 +1,299 @@
+#include "Scene/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "Core.h"
+
+namespace
+{
+	constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+	// Number of cache misses of every triangle with a FIFO cache
+	std::vector<uint8_t> SimulateCacheMisses(const std::vector<uint32_t>& kIndices, const size_t kVertexCount, const uint32_t kCacheSize)
+	{
+		std::vector<uint8_t> misses(kIndices.size() / 3, 0);
+
+		// A vertex is in the cache if it was pushed less than kCacheSize pushes ago
+		std::vector<uint32_t> timestamps(kVertexCount, 0);
+		uint32_t time = kCacheSize + 1;
+
+		for (size_t i = 0; i < kIndices.size(); ++i)
+		{
+			const uint32_t kIndex = kIndices[i];
+			if (time - timestamps[kIndex] > kCacheSize)
+			{
+				timestamps[kIndex] = time++;
+				misses[i / 3]++;
+			}
+		}
+
+		return misses;
+	}
+}
+
+void BuildTriangleAdjacency(const std::vector<uint32_t>& kIndices, const size_t kVertexCount, TriangleAdjacency& adjacency)
+{
+	adjacency._offsets.assign(kVertexCount + 1, 0);
+	for (const uint32_t kIndex : kIndices)
+		adjacency._offsets[kIndex + 1]++;
+
+	for (size_t i = 0; i < kVertexCount; ++i)
+		adjacency._offsets[i + 1] += adjacency._offsets[i];
+
+	adjacency._triangles.resize(kIndices.size());
+	std::vector<uint32_t> fill(adjacency._offsets.begin(), adjacency._offsets.end() - 1);
+	for (size_t i = 0; i < kIndices.size(); ++i)
+		adjacency._triangles[fill[kIndices[i]]++] = static_cast<uint32_t>(i / 3);
+}
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& kIndices, const size_t kVertexCount, const uint32_t kCacheSize)
+{
+	ASSERT(kIndices.size() % 3 == 0, "indices are not a triangle list")
+
+	VertexCacheStatistics statistics;
+	if (kIndices.empty() || kVertexCount == 0)
+		return statistics;
+
+	for (const uint8_t kMisses : SimulateCacheMisses(kIndices, kVertexCount, kCacheSize))
+		statistics._transformedVertices += kMisses;
+
+	statistics._acmr = static_cast<float>(statistics._transformedVertices) / static_cast<float>(kIndices.size() / 3);
+	statistics._atvr = static_cast<float>(statistics._transformedVertices) / static_cast<float>(kVertexCount);
+
+	return statistics;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, const size_t kVertexCount, const uint32_t kCacheSize)
+{
+	ASSERT(indices.size() % 3 == 0, "indices are not a triangle list")
+	if (indices.empty())
+		return;
+
+	const size_t kTriangleCount = indices.size() / 3;
+
+	TriangleAdjacency adjacency;
+	BuildTriangleAdjacency(indices, kVertexCount, adjacency);
+
+	std::vector<uint32_t> liveTriangles(kVertexCount);
+	for (size_t i = 0; i < kVertexCount; ++i)
+		liveTriangles[i] = adjacency._offsets[i + 1] - adjacency._offsets[i];
+
+	std::vector<uint32_t> timestamps(kVertexCount, 0);
+	std::vector<bool> emitted(kTriangleCount, false);
+
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	deadEnds.reserve(indices.size());
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t time = kCacheSize + 1;
+	size_t cursor = 0;
+
+	// Next vertex with live triangles, first from the recently used ones then in input order
+	const auto skipDeadEnd = [&]() -> uint32_t {
+		while (!deadEnds.empty())
+		{
+			const uint32_t kVertex = deadEnds.back();
+			deadEnds.pop_back();
+
+			if (liveTriangles[kVertex] > 0)
+				return kVertex;
+		}
+
+		for (; cursor < kVertexCount; ++cursor)
+		{
+			if (liveTriangles[cursor] > 0)
+				return static_cast<uint32_t>(cursor);
+		}
+
+		return INVALID_INDEX;
+	};
+
+	uint32_t fanningVertex = skipDeadEnd();
+	while (fanningVertex != INVALID_INDEX)
+	{
+		candidates.clear();
+
+		for (uint32_t t = adjacency._offsets[fanningVertex]; t < adjacency._offsets[fanningVertex + 1]; ++t)
+		{
+			const uint32_t kTriangle = adjacency._triangles[t];
+			if (emitted[kTriangle])
+				continue;
+
+			for (size_t v = 0; v < 3; ++v)
+			{
+				const uint32_t kVertex = indices[kTriangle * 3 + v];
+				result.push_back(kVertex);
+
+				deadEnds.push_back(kVertex);
+				candidates.push_back(kVertex);
+				liveTriangles[kVertex]--;
+
+				if (time - timestamps[kVertex] > kCacheSize)
+					timestamps[kVertex] = time++;
+			}
+
+			emitted[kTriangle] = true;
+		}
+
+		// Prefer the candidate that will still be in cache once all its triangles are emitted, the oldest one first
+		uint32_t nextVertex = INVALID_INDEX;
+		int32_t bestPriority = -1;
+		for (const uint32_t kVertex : candidates)
+		{
+			if (liveTriangles[kVertex] == 0)
+				continue;
+
+			int32_t priority = 0;
+			if (time - timestamps[kVertex] + 2 * liveTriangles[kVertex] <= kCacheSize)
+				priority = static_cast<int32_t>(time - timestamps[kVertex]);
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				nextVertex = kVertex;
+			}
+		}
+
+		fanningVertex = nextVertex != INVALID_INDEX ? nextVertex : skipDeadEnd();
+	}
+
+	ASSERT(result.size() == indices.size(), "vertex cache optimization lost triangles")
+	indices = std::move(result);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& kVertices, const float kThreshold, const uint32_t kCacheSize)
+{
+	ASSERT(indices.size() % 3 == 0, "indices are not a triangle list")
+	if (indices.empty())
+		return;
+
+	const size_t kTriangleCount = indices.size() / 3;
+	const std::vector<uint8_t> kMisses = SimulateCacheMisses(indices, kVertices.size(), kCacheSize);
+
+	// Hard boundaries: the cache was fully flushed, reordering there costs nothing
+	std::vector<size_t> hardClusters;
+	for (size_t t = 0; t < kTriangleCount; ++t)
+	{
+		if (t == 0 || kMisses[t] == 3)
+			hardClusters.push_back(t);
+	}
+	hardClusters.push_back(kTriangleCount);
+
+	// Soft boundaries: split further while the cluster keeps an ACMR close to the one of its hard cluster
+	std::vector<size_t> clusters;
+	for (size_t c = 0; c + 1 < hardClusters.size(); ++c)
+	{
+		const size_t kBegin = hardClusters[c];
+		const size_t kEnd = hardClusters[c + 1];
+
+		uint32_t clusterMisses = 0;
+		for (size_t t = kBegin; t < kEnd; ++t)
+			clusterMisses += kMisses[t];
+		const float kClusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(kEnd - kBegin);
+
+		clusters.push_back(kBegin);
+
+		uint32_t misses = 0;
+		size_t start = kBegin;
+		for (size_t t = kBegin; t < kEnd; ++t)
+		{
+			misses += kMisses[t];
+
+			const float kAcmr = static_cast<float>(misses) / static_cast<float>(t + 1 - start);
+			if (t + 1 < kEnd && kAcmr <= kClusterAcmr * kThreshold)
+			{
+				clusters.push_back(t + 1);
+				start = t + 1;
+				misses = 0;
+			}
+		}
+	}
+	clusters.push_back(kTriangleCount);
+
+	// Mesh centroid, area weighted
+	Vec3 meshCentroid{ 0.f, 0.f, 0.f };
+	float meshArea = 0.f;
+	for (size_t t = 0; t < kTriangleCount; ++t)
+	{
+		const Vec3& kP0 = kVertices[indices[t * 3 + 0]].pos;
+		const Vec3& kP1 = kVertices[indices[t * 3 + 1]].pos;
+		const Vec3& kP2 = kVertices[indices[t * 3 + 2]].pos;
+
+		const float kArea = glm::length(glm::cross(kP1 - kP0, kP2 - kP0));
+		meshCentroid += (kP0 + kP1 + kP2) * (kArea / 3.f);
+		meshArea += kArea;
+	}
+	if (meshArea > 0.f)
+		meshCentroid /= meshArea;
+
+	// Clusters far from the center and facing away from it are the most likely to occlude the others
+	const size_t kClusterCount = clusters.size() - 1;
+	std::vector<float> sortKeys(kClusterCount, 0.f);
+	for (size_t c = 0; c < kClusterCount; ++c)
+	{
+		Vec3 centroid{ 0.f, 0.f, 0.f };
+		Vec3 normal{ 0.f, 0.f, 0.f };
+		float area = 0.f;
+
+		for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const Vec3& kP0 = kVertices[indices[t * 3 + 0]].pos;
+			const Vec3& kP1 = kVertices[indices[t * 3 + 1]].pos;
+			const Vec3& kP2 = kVertices[indices[t * 3 + 2]].pos;
+
+			const Vec3 kNormal = glm::cross(kP1 - kP0, kP2 - kP0);
+			const float kArea = glm::length(kNormal);
+
+			centroid += (kP0 + kP1 + kP2) * (kArea / 3.f);
+			normal += kNormal;
+			area += kArea;
+		}
+
+		if (area > 0.f)
+			centroid /= area;
+
+		const float kNormalLength = glm::length(normal);
+		if (kNormalLength > 0.f)
+			normal /= kNormalLength;
+
+		sortKeys[c] = glm::dot(centroid - meshCentroid, normal);
+	}
+
+	std::vector<uint32_t> order(kClusterCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](const uint32_t kA, const uint32_t kB) { return sortKeys[kA] > sortKeys[kB]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (const uint32_t kCluster : order)
+		result.insert(result.end(), indices.begin() + clusters[kCluster] * 3, indices.begin() + clusters[kCluster + 1] * 3);
+
+	indices = std::move(result);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+
+	std::vector<Vertex> result;
+	result.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		ASSERT(index < vertices.size(), "index out of range")
+
+		if (remap[index] == INVALID_INDEX)
+		{
+			remap[index] = static_cast<uint32_t>(result.size());
+			result.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(result);
+}
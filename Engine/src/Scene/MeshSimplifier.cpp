@@ -0,0 +1,281 @@
+#include "Scene/MeshSimplifier.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+#include <cmath>
+
+#include "Core.h"
+#include "Scene/MeshOptimizer.h"
+
+namespace
+{
+	// Symmetric 4x4 matrix summing the squared distance to planes, weighted by the area of their triangle
+	struct Quadric
+	{
+		double _a00 = 0., _a01 = 0., _a02 = 0., _a03 = 0.;
+		double _a11 = 0., _a12 = 0., _a13 = 0.;
+		double _a22 = 0., _a23 = 0.;
+		double _a33 = 0.;
+		double _weight = 0.;
+
+		void AddPlane(const double kA, const double kB, const double kC, const double kD, const double kWeight)
+		{
+			_a00 += kWeight * kA * kA; _a01 += kWeight * kA * kB; _a02 += kWeight * kA * kC; _a03 += kWeight * kA * kD;
+			_a11 += kWeight * kB * kB; _a12 += kWeight * kB * kC; _a13 += kWeight * kB * kD;
+			_a22 += kWeight * kC * kC; _a23 += kWeight * kC * kD;
+			_a33 += kWeight * kD * kD;
+			_weight += kWeight;
+		}
+
+		Quadric& operator+=(const Quadric& kQuadric)
+		{
+			_a00 += kQuadric._a00; _a01 += kQuadric._a01; _a02 += kQuadric._a02; _a03 += kQuadric._a03;
+			_a11 += kQuadric._a11; _a12 += kQuadric._a12; _a13 += kQuadric._a13;
+			_a22 += kQuadric._a22; _a23 += kQuadric._a23;
+			_a33 += kQuadric._a33;
+			_weight += kQuadric._weight;
+			return *this;
+		}
+
+		// Mean distance of kPos to the planes
+		float Error(const Vec3& kPos) const
+		{
+			if (_weight <= 0.)
+				return 0.f;
+
+			const double kX = kPos.x, kY = kPos.y, kZ = kPos.z;
+			const double kRx = _a00 * kX + _a01 * kY + _a02 * kZ + _a03;
+			const double kRy = _a01 * kX + _a11 * kY + _a12 * kZ + _a13;
+			const double kRz = _a02 * kX + _a12 * kY + _a22 * kZ + _a23;
+			const double kRw = _a03 * kX + _a13 * kY + _a23 * kZ + _a33;
+
+			const double kError = kRx * kX + kRy * kY + kRz * kZ + kRw;
+			return static_cast<float>(std::sqrt(std::max(kError, 0.) / _weight));
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t	_from;
+		uint32_t	_to;
+		float		_error;
+	};
+
+	// Id of the first vertex sharing the position of each vertex, vertices split by uv or normal seams get the same id
+	std::vector<uint32_t> BuildPositionIds(const std::vector<Vertex>& kVertices)
+	{
+		std::vector<uint32_t> order(kVertices.size());
+		std::iota(order.begin(), order.end(), 0u);
+
+		const auto kLess = [&kVertices](const uint32_t kLhs, const uint32_t kRhs)
+		{
+			const Vec3& kA = kVertices[kLhs].pos;
+			const Vec3& kB = kVertices[kRhs].pos;
+			if (kA.x != kB.x)
+				return kA.x < kB.x;
+			if (kA.y != kB.y)
+				return kA.y < kB.y;
+			if (kA.z != kB.z)
+				return kA.z < kB.z;
+			return kLhs < kRhs;
+		};
+		std::sort(order.begin(), order.end(), kLess);
+
+		std::vector<uint32_t> positionIds(kVertices.size());
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			const bool kSame = i > 0 && kVertices[order[i]].pos == kVertices[order[i - 1]].pos;
+			positionIds[order[i]] = kSame ? positionIds[order[i - 1]] : order[i];
+		}
+
+		return positionIds;
+	}
+
+	std::vector<bool> BuildLockedVertices(const std::vector<uint32_t>& kIndices, const std::vector<uint32_t>& kPositionIds)
+	{
+		const size_t kVertexCount = kPositionIds.size();
+
+		std::vector<uint32_t> sharedCount(kVertexCount, 0);
+		for (size_t i = 0; i < kVertexCount; ++i)
+			sharedCount[kPositionIds[i]]++;
+
+		// An edge used in one direction only is on a border
+		std::unordered_set<uint64_t> edges;
+		edges.reserve(kIndices.size());
+		for (size_t i = 0; i < kIndices.size(); ++i)
+		{
+			const uint32_t kA = kPositionIds[kIndices[i]];
+			const uint32_t kB = kPositionIds[kIndices[i - i % 3 + (i + 1) % 3]];
+			edges.insert((static_cast<uint64_t>(kA) << 32) | kB);
+		}
+
+		std::vector<bool> lockedPositions(kVertexCount, false);
+		for (size_t i = 0; i < kVertexCount; ++i)
+			lockedPositions[i] = sharedCount[i] > 1;
+
+		for (size_t i = 0; i < kIndices.size(); ++i)
+		{
+			const uint32_t kA = kPositionIds[kIndices[i]];
+			const uint32_t kB = kPositionIds[kIndices[i - i % 3 + (i + 1) % 3]];
+			if (edges.find((static_cast<uint64_t>(kB) << 32) | kA) == edges.end())
+				lockedPositions[kA] = lockedPositions[kB] = true;
+		}
+
+		std::vector<bool> locked(kVertexCount);
+		for (size_t i = 0; i < kVertexCount; ++i)
+			locked[i] = lockedPositions[kPositionIds[i]];
+
+		return locked;
+	}
+
+	// Moving kFrom onto kTo must not flip or squash the triangles that survive the collapse
+	bool IsCollapseValid(const std::vector<uint32_t>& kIndices, const std::vector<Vertex>& kVertices,
+						const uint32_t* kTriangles, const uint32_t kTriangleCount, const uint32_t kFrom, const uint32_t kTo)
+	{
+		for (uint32_t i = 0; i < kTriangleCount; ++i)
+		{
+			const uint32_t* kTriangle = &kIndices[kTriangles[i] * 3];
+			if (kTriangle[0] == kTo || kTriangle[1] == kTo || kTriangle[2] == kTo)
+				continue;
+
+			Vec3 before[3];
+			Vec3 after[3];
+			for (int j = 0; j < 3; ++j)
+			{
+				before[j] = kVertices[kTriangle[j]].pos;
+				after[j] = kTriangle[j] == kFrom ? kVertices[kTo].pos : before[j];
+			}
+
+			const Vec3 kNormalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			const Vec3 kNormalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+			// Rejects flips and triangles turning by more than ~75 degrees
+			const float kDot = glm::dot(kNormalBefore, kNormalAfter);
+			if (kDot <= 0.25f * glm::length(kNormalBefore) * glm::length(kNormalAfter))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t>& kIndices, const std::vector<Vertex>& kVertices,
+									const size_t kTargetIndexCount, const float kTargetError, float* resultError)
+{
+	ASSERT(kIndices.size() % 3 == 0, "indices are not a triangle list")
+
+	const size_t kVertexCount = kVertices.size();
+	std::vector<uint32_t> indices = kIndices;
+	float maxError = 0.f;
+
+	const std::vector<uint32_t> kPositionIds = BuildPositionIds(kVertices);
+	const std::vector<bool> kLocked = BuildLockedVertices(indices, kPositionIds);
+
+	// Quadrics are shared by the vertices of a same position
+	std::vector<Quadric> quadrics(kVertexCount);
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const Vec3& kP0 = kVertices[indices[i]].pos;
+		const Vec3& kP1 = kVertices[indices[i + 1]].pos;
+		const Vec3& kP2 = kVertices[indices[i + 2]].pos;
+
+		const Vec3 kCross = glm::cross(kP1 - kP0, kP2 - kP0);
+		const float kLength = glm::length(kCross);
+		if (kLength <= 0.f)
+			continue;
+
+		const Vec3 kNormal = kCross / kLength;
+		const double kArea = 0.5 * kLength;
+		for (int j = 0; j < 3; ++j)
+			quadrics[kPositionIds[indices[i + j]]].AddPlane(kNormal.x, kNormal.y, kNormal.z, -glm::dot(kNormal, kP0), kArea);
+	}
+
+	std::vector<uint32_t> remap(kVertexCount);
+	std::vector<bool> touched(kVertexCount);
+	TriangleAdjacency adjacency;
+	std::vector<Collapse> collapses;
+
+	// Each pass collapses the cheapest independent edges then rebuilds the index buffer
+	while (indices.size() > kTargetIndexCount)
+	{
+		collapses.clear();
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			const uint32_t kA = indices[i];
+			const uint32_t kB = indices[i - i % 3 + (i + 1) % 3];
+
+			Quadric quadric = quadrics[kPositionIds[kA]];
+			quadric += quadrics[kPositionIds[kB]];
+
+			if (!kLocked[kA])
+				collapses.push_back({ kA, kB, quadric.Error(kVertices[kB].pos) });
+			if (!kLocked[kB])
+				collapses.push_back({ kB, kA, quadric.Error(kVertices[kA].pos) });
+		}
+
+		if (collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& kLhs, const Collapse& kRhs) { return kLhs._error < kRhs._error; });
+
+		BuildTriangleAdjacency(indices, kVertexCount, adjacency);
+
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(touched.begin(), touched.end(), false);
+
+		size_t indexCount = indices.size();
+		size_t collapseCount = 0;
+		for (const Collapse& kCollapse : collapses)
+		{
+			if (kCollapse._error > kTargetError || indexCount <= kTargetIndexCount)
+				break;
+
+			if (touched[kCollapse._from] || touched[kCollapse._to])
+				continue;
+
+			const uint32_t* kTriangles = &adjacency._triangles[adjacency._offsets[kCollapse._from]];
+			const uint32_t kTriangleCount = adjacency._offsets[kCollapse._from + 1] - adjacency._offsets[kCollapse._from];
+			if (!IsCollapseValid(indices, kVertices, kTriangles, kTriangleCount, kCollapse._from, kCollapse._to))
+				continue;
+
+			// Neighbours are frozen until the next pass so the flip test above stays true
+			for (uint32_t i = 0; i < kTriangleCount; ++i)
+			{
+				const uint32_t* kTriangle = &indices[kTriangles[i] * 3];
+				touched[kTriangle[0]] = touched[kTriangle[1]] = touched[kTriangle[2]] = true;
+
+				if (kTriangle[0] == kCollapse._to || kTriangle[1] == kCollapse._to || kTriangle[2] == kCollapse._to)
+					indexCount -= 3;
+			}
+
+			remap[kCollapse._from] = kCollapse._to;
+			quadrics[kPositionIds[kCollapse._to]] += quadrics[kPositionIds[kCollapse._from]];
+			maxError = std::max(maxError, kCollapse._error);
+			collapseCount++;
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		size_t write = 0;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const uint32_t kA = remap[indices[i]];
+			const uint32_t kB = remap[indices[i + 1]];
+			const uint32_t kC = remap[indices[i + 2]];
+			if (kA == kB || kB == kC || kC == kA)
+				continue;
+
+			indices[write++] = kA;
+			indices[write++] = kB;
+			indices[write++] = kC;
+		}
+		indices.resize(write);
+	}
+
+	if (resultError != nullptr)
+		*resultError = maxError;
+
+	return indices;
+}
@@ -0,0 +1,189 @@
+#include "Scene/Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Core.h"
+
+namespace
+{
+	constexpr uint8_t INVALID_LOCAL_INDEX = UINT8_MAX;
+
+	void ComputeBounds(Meshlet& meshlet, const MeshletData& kData, const std::vector<Vertex>& kVertices)
+	{
+		const uint32_t* kMeshletVertices = &kData._vertices[meshlet._vertexOffset];
+		const uint8_t* kMeshletTriangles = &kData._triangles[meshlet._triangleOffset * 3];
+
+		Vec3 min = kVertices[kMeshletVertices[0]].pos;
+		Vec3 max = min;
+		for (uint32_t i = 1; i < meshlet._vertexCount; ++i)
+		{
+			min = glm::min(min, kVertices[kMeshletVertices[i]].pos);
+			max = glm::max(max, kVertices[kMeshletVertices[i]].pos);
+		}
+
+		meshlet._center = (min + max) * 0.5f;
+		meshlet._radius = 0.f;
+		for (uint32_t i = 0; i < meshlet._vertexCount; ++i)
+			meshlet._radius = std::max(meshlet._radius, glm::distance(meshlet._center, kVertices[kMeshletVertices[i]].pos));
+
+		// Cone axis is the mean of the triangle normals, degenerate triangles don't constrain it
+		std::vector<Vec3> normals(meshlet._triangleCount, Vec3(0.f));
+		std::vector<Vec3> corners(meshlet._triangleCount, Vec3(0.f));
+		Vec3 axis(0.f);
+		for (uint32_t i = 0; i < meshlet._triangleCount; ++i)
+		{
+			const Vec3& kP0 = kVertices[kMeshletVertices[kMeshletTriangles[i * 3]]].pos;
+			const Vec3& kP1 = kVertices[kMeshletVertices[kMeshletTriangles[i * 3 + 1]]].pos;
+			const Vec3& kP2 = kVertices[kMeshletVertices[kMeshletTriangles[i * 3 + 2]]].pos;
+
+			const Vec3 kCross = glm::cross(kP1 - kP0, kP2 - kP0);
+			const float kLength = glm::length(kCross);
+			if (kLength > 0.f)
+				normals[i] = kCross / kLength;
+
+			corners[i] = kP0;
+			axis += normals[i];
+		}
+
+		meshlet._coneApex = meshlet._center;
+		meshlet._coneAxis = Vec3(0.f, 0.f, 1.f);
+		meshlet._coneCutoff = 1.f;
+
+		const float kAxisLength = glm::length(axis);
+		if (kAxisLength <= 0.f)
+			return;
+		axis /= kAxisLength;
+
+		float minDot = 1.f;
+		for (const Vec3& kNormal : normals)
+		{
+			if (kNormal != Vec3(0.f))
+				minDot = std::min(minDot, glm::dot(kNormal, axis));
+		}
+
+		meshlet._coneAxis = axis;
+
+		// Normals spread over more than a hemisphere, no view direction sees only back faces
+		if (minDot <= 0.1f)
+			return;
+
+		// Apex is moved back along the axis until it is behind every triangle plane
+		float maxT = 0.f;
+		for (uint32_t i = 0; i < meshlet._triangleCount; ++i)
+		{
+			if (normals[i] == Vec3(0.f))
+				continue;
+
+			const float kDistance = glm::dot(meshlet._center - corners[i], normals[i]);
+			maxT = std::max(maxT, kDistance / glm::dot(axis, normals[i]));
+		}
+
+		meshlet._coneApex = meshlet._center - axis * maxT;
+		meshlet._coneCutoff = std::sqrt(1.f - minDot * minDot);
+	}
+}
+
+MeshletData BuildMeshlets(const std::vector<uint32_t>& kIndices, const std::vector<Vertex>& kVertices,
+							const uint32_t kMaxVertices, const uint32_t kMaxTriangles)
+{
+	ASSERT(kIndices.size() % 3 == 0, "indices are not a triangle list")
+	ASSERT(kMaxVertices >= 3 && kMaxVertices < INVALID_LOCAL_INDEX, "kMaxVertices doesn't fit in the meshlet triangles")
+	ASSERT(kMaxTriangles >= 1, "kMaxTriangles is 0")
+
+	MeshletData data;
+
+	// Local index of every mesh vertex in the meshlet being built
+	std::vector<uint8_t> localIndices(kVertices.size(), INVALID_LOCAL_INDEX);
+
+	Meshlet meshlet{};
+	const auto kFlush = [&]()
+	{
+		if (meshlet._triangleCount == 0)
+			return;
+
+		for (uint32_t i = 0; i < meshlet._vertexCount; ++i)
+			localIndices[data._vertices[meshlet._vertexOffset + i]] = INVALID_LOCAL_INDEX;
+
+		ComputeBounds(meshlet, data, kVertices);
+		data._meshlets.push_back(meshlet);
+
+		meshlet = Meshlet{};
+		meshlet._vertexOffset = static_cast<uint32_t>(data._vertices.size());
+		meshlet._triangleOffset = static_cast<uint32_t>(data._triangles.size() / 3);
+	};
+
+	for (size_t i = 0; i < kIndices.size(); i += 3)
+	{
+		uint32_t newVertices = 0;
+		for (size_t j = 0; j < 3; ++j)
+			newVertices += localIndices[kIndices[i + j]] == INVALID_LOCAL_INDEX;
+
+		if (meshlet._vertexCount + newVertices > kMaxVertices || meshlet._triangleCount + 1 > kMaxTriangles)
+			kFlush();
+
+		for (size_t j = 0; j < 3; ++j)
+		{
+			uint8_t& localIndex = localIndices[kIndices[i + j]];
+			if (localIndex == INVALID_LOCAL_INDEX)
+			{
+				localIndex = static_cast<uint8_t>(meshlet._vertexCount++);
+				data._vertices.push_back(kIndices[i + j]);
+			}
+
+			data._triangles.push_back(localIndex);
+		}
+		meshlet._triangleCount++;
+	}
+	kFlush();
+
+	return data;
+}
+
+Frustum ExtractFrustum(const Mat4& kViewProjection)
+{
+	// Gribb & Hartmann, rows of the matrix with a [0, 1] depth range
+	const auto kRow = [&kViewProjection](const int kIndex)
+	{
+		return Vec4(kViewProjection[0][kIndex], kViewProjection[1][kIndex], kViewProjection[2][kIndex], kViewProjection[3][kIndex]);
+	};
+
+	const Vec4 kRow0 = kRow(0);
+	const Vec4 kRow1 = kRow(1);
+	const Vec4 kRow2 = kRow(2);
+	const Vec4 kRow3 = kRow(3);
+
+	Frustum frustum{};
+	frustum._planes[0] = kRow3 + kRow0;	// left
+	frustum._planes[1] = kRow3 - kRow0;	// right
+	frustum._planes[2] = kRow3 + kRow1;	// bottom
+	frustum._planes[3] = kRow3 - kRow1;	// top
+	frustum._planes[4] = kRow2;			// near
+	frustum._planes[5] = kRow3 - kRow2;	// far
+
+	for (Vec4& plane : frustum._planes)
+		plane = plane * (1.f / glm::length(Vec3(plane)));
+
+	return frustum;
+}
+
+bool IsMeshletBackfacing(const Meshlet& kMeshlet, const Vec3& kCameraPos)
+{
+	const Vec3 kDirection = kMeshlet._coneApex - kCameraPos;
+	const float kLength = glm::length(kDirection);
+	if (kLength <= 0.f)
+		return false;
+
+	return glm::dot(kDirection / kLength, kMeshlet._coneAxis) >= kMeshlet._coneCutoff;
+}
+
+bool IsMeshletInFrustum(const Meshlet& kMeshlet, const Frustum& kFrustum)
+{
+	for (const Vec4& kPlane : kFrustum._planes)
+	{
+		if (glm::dot(Vec3(kPlane), kMeshlet._center) + kPlane.w < -kMeshlet._radius)
+			return false;
+	}
+
+	return true;
+}
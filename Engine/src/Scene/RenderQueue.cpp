@@ -0,0 +1,117 @@
+#include "Scene/RenderQueue.h"
+
+#include "Core.h"
+
+#include <array>
+#include <cstring>
+
+namespace
+{
+	template<typename Key>
+	uint32_t GetId(std::unordered_map<Key, uint32_t>& ids, const Key kKey, [[maybe_unused]] const uint32_t kBits)
+	{
+		const auto kIt = ids.find(kKey);
+		if (kIt != ids.end())
+			return kIt->second;
+
+		const uint32_t kId = static_cast<uint32_t>(ids.size());
+		ASSERT(kId < (1u << kBits), "more than " + std::to_string(1u << kBits) + " ids in the render queue keys")
+		ids.emplace(kKey, kId);
+		return kId;
+	}
+}
+
+uint64_t RenderQueue::MakeKey(const Pass kPass, const uint32_t kPipelineId, const uint32_t kMaterialId, const uint32_t kMeshId, const float kDepth)
+{
+	// Positive floats sort as their bits, the mantissa low bits are dropped
+	const float kPositiveDepth = kDepth > 0.f ? kDepth : 0.f;
+	uint32_t depthBits = 0;
+	std::memcpy(&depthBits, &kPositiveDepth, sizeof(float));
+	const uint64_t kDepthKey = depthBits >> (32 - DEPTH_BITS);
+
+	uint64_t key = static_cast<uint64_t>(kPass);
+	if (kPass == Pass::OPAQUE)
+	{
+		key = (key << PIPELINE_BITS) | kPipelineId;
+		key = (key << MATERIAL_BITS) | kMaterialId;
+		key = (key << MESH_BITS) | kMeshId;
+		key = (key << DEPTH_BITS) | kDepthKey;
+	}
+	else
+	{
+		const uint64_t kDepthMask = (1ull << DEPTH_BITS) - 1;
+		key = (key << DEPTH_BITS) | (~kDepthKey & kDepthMask);
+		key = (key << PIPELINE_BITS) | kPipelineId;
+		key = (key << MATERIAL_BITS) | kMaterialId;
+		key = (key << MESH_BITS) | kMeshId;
+	}
+
+	return key;
+}
+
+void RenderQueue::Clear()
+{
+	_packets.clear();
+}
+
+void RenderQueue::Push(const Actor& kActor, const Camera* kCamera, const float kViewportHeight)
+{
+	const MaterialInstance* kMaterial = kActor.GetDrawable();
+	if (kMaterial == nullptr)
+		return;
+
+	const Pass kPass = kMaterial->_kMaterial->_transparent ? Pass::TRANSPARENT : Pass::OPAQUE;
+	const uint32_t kPipelineId = GetId<uint64_t>(_pipelineIds, (uint64_t)kMaterial->_variant->_pipeline, PIPELINE_BITS);
+	const uint32_t kMaterialId = GetId<const void*>(_materialIds, kMaterial, MATERIAL_BITS);
+	const uint32_t kMeshId = GetId<const void*>(_meshIds, &kActor.GetMesh(), MESH_BITS);
+
+	Packet packet;
+	packet._actor = &kActor;
+	if (kCamera != nullptr)
+	{
+		packet._key = MakeKey(kPass, kPipelineId, kMaterialId, kMeshId, kActor.GetDistance(*kCamera));
+		packet._lod = kActor.SelectLod(*kCamera, kViewportHeight);
+	}
+	else
+		packet._key = MakeKey(kPass, kPipelineId, kMaterialId, kMeshId, 0.f);
+
+	_packets.push_back(packet);
+}
+
+void RenderQueue::Sort()
+{
+	if (_packets.size() < 2)
+		return;
+
+	_sortBuffer.resize(_packets.size());
+
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		std::array<size_t, 256> offsets{};
+		for (const Packet& kPacket : _packets)
+			++offsets[(kPacket._key >> shift) & 0xFF];
+
+		// Every key has the same byte, the pass wouldn't move anything
+		if (offsets[(_packets[0]._key >> shift) & 0xFF] == _packets.size())
+			continue;
+
+		size_t sum = 0;
+		for (size_t& offset : offsets)
+		{
+			const size_t kCount = offset;
+			offset = sum;
+			sum += kCount;
+		}
+
+		for (const Packet& kPacket : _packets)
+			_sortBuffer[offsets[(kPacket._key >> shift) & 0xFF]++] = kPacket;
+
+		_packets.swap(_sortBuffer);
+	}
+}
+
+void RenderQueue::Draw(CommandRecorder& recorder, const DynamicOffsets& kDynamicOffsets) const
+{
+	for (const Packet& kPacket : _packets)
+		kPacket._actor->Draw(recorder, kDynamicOffsets, kPacket._lod);
+}
@@ -3,6 +3,7 @@
 #include <chrono>
 
 #include "ImGuiSystem.h"
+#include "Scene/RenderQueue.h"
 
 void Draw(const Scene& scene)
 {
@@ -29,6 +30,13 @@ void Draw(const Scene& scene)
 
 	static float rUp[3]{ 0.f, 1.f, 0.f };
 
+	DynamicOffsets dynamicOffsets{};
+	if (scene._camera != nullptr)
+		dynamicOffsets[static_cast<size_t>(BindingsSet::Scope::GLOBAL)] = scene._camera->_uboOffset;
+
+
+	RenderQueue renderQueue;
+	CommandRecorder::Stats frameStats;
 
 	// in the end, may use secondary buffer to avoid record scene foreach viewport
 	for (size_t i = 0; i < scene._viewports.size(); ++i)
@@ -37,9 +45,8 @@ void Draw(const Scene& scene)
 			0.1f, 512.0f);
 		ubo.proj[1][1] *= -1;*/
 
-		scene._viewports[i]->StartDraw();
-
-		// foreach mesh draw
+		// foreach mesh draw, recorded in key order instead of the order of the actors
+		renderQueue.Clear();
 		for (size_t j = 0; j < scene._actors.size(); ++j)
 		{
 			/*ImGui::BeginGroup();
@@ -49,12 +56,23 @@ void Draw(const Scene& scene)
 
 			//ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(45.0f), glm::vec3(rUp[0], rUp[1], rUp[2]));
 
-			scene._actors[j]->Draw(scene._viewports[i]->_commandBuffer);
+			renderQueue.Push(*scene._actors[j], scene._camera, static_cast<float>(scene._viewports[i]->_size.height));
 		}
+		renderQueue.Sort();
+
+		scene._viewports[i]->StartDraw();
+		CommandRecorder recorder(scene._viewports[i]->_commandBuffer);
+
+		renderQueue.Draw(recorder, dynamicOffsets);
 
 		scene._viewports[i]->EndDraw();
+
+		frameStats._binds += recorder._stats._binds;
+		frameStats._elided += recorder._stats._elided;
 	}
 
+	ImGui::Text("Binds %u, elided %u", frameStats._binds, frameStats._elided);
+
 	ImGui::End();
 
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "Scene/VertexWelder.h"
+
+#include <algorithm>
+
+#include "Core.h"
+
+namespace
+{
+	size_t NextPowerOfTwo(const size_t kValue)
+	{
+		size_t power = 1;
+		while (power < kValue)
+			power <<= 1;
+
+		return power;
+	}
+}
+
+VertexWelder::VertexWelder(std::vector<Vertex>& vertices, const size_t kExpectedVertexCount)
+	: _vertices{ vertices }
+{
+	// Keep the load factor under 0.5 for the expected count, linear probing degrades quickly above
+	_slots.resize(NextPowerOfTwo(std::max<size_t>(kExpectedVertexCount * 2, 16)));
+	_mask = _slots.size() - 1;
+
+	_vertices.reserve(_vertices.size() + kExpectedVertexCount);
+}
+
+void VertexWelder::Grow()
+{
+	std::vector<Slot> slots(_slots.size() * 2);
+	const size_t mask = slots.size() - 1;
+
+	for (const Slot& kSlot : _slots)
+	{
+		if (kSlot._index == EMPTY_SLOT)
+			continue;
+
+		size_t i = kSlot._hash & mask;
+		while (slots[i]._index != EMPTY_SLOT)
+			i = (i + 1) & mask;
+
+		slots[i] = kSlot;
+	}
+
+	_slots = std::move(slots);
+	_mask = mask;
+}
+
+std::pair<uint32_t, bool> VertexWelder::Weld(const Vertex& kVertex)
+{
+	const uint32_t hash = static_cast<uint32_t>(std::hash<Vertex>()(kVertex));
+
+	size_t i = hash & _mask;
+	while (_slots[i]._index != EMPTY_SLOT)
+	{
+		const Slot& kSlot = _slots[i];
+		if (kSlot._hash == hash && _vertices[kSlot._index] == kVertex)
+			return { kSlot._index, false };
+
+		i = (i + 1) & _mask;
+	}
+
+	ASSERT(_vertices.size() < EMPTY_SLOT, "too many vertices to weld")
+
+	const uint32_t index = static_cast<uint32_t>(_vertices.size());
+	_slots[i] = { hash, index };
+	_vertices.push_back(kVertex);
+	++_count;
+
+	if (2 * _count > _slots.size())
+		Grow();
+
+	return { index, true };
+}
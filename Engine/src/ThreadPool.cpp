@@ -0,0 +1,70 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+#include "Core.h"
+
+namespace ez
+{
+	ThreadPool* ThreadPool::_sInstance = nullptr;
+
+	ThreadPool& ThreadPool::Instance()
+	{
+		ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+		return *_sInstance;
+	}
+
+	ThreadPool::ThreadPool(const size_t kThreadCount)
+	{
+		ASSERT(_sInstance == nullptr, "_sInstance is already set")
+		_sInstance = this;
+
+		// hardware_concurrency can return 0 when it is not computable
+		const size_t threadCount = std::max<size_t>(kThreadCount, 1u);
+
+		_workers.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i)
+			_workers.emplace_back(&ThreadPool::Work, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stop = true;
+		}
+		_condition.notify_all();
+
+		for (std::thread& worker : _workers)
+			worker.join();
+
+		_sInstance = nullptr;
+	}
+
+	void ThreadPool::Work()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this] { return _stop || !_tasks.empty(); });
+
+				// Pending tasks are still executed on shutdown so no future is left broken
+				if (_stop && _tasks.empty())
+					return;
+
+				task = std::move(_tasks.front());
+				_tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+	size_t ThreadPool::Size() const
+	{
+		return _workers.size();
+	}
+}
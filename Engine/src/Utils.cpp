@@ -4,6 +4,7 @@
 #include "imgui_internal.h"
 
 #include <string>
+#include <cstring>
 
 namespace ez
 {
@@ -25,6 +26,39 @@ namespace ez
 		return output;
 	}
 
+	uint64_t HashBytes(const void* kData, const size_t kSize)
+	{
+		const uint8_t* kBytes = static_cast<const uint8_t*>(kData);
+
+		uint64_t hash = 0x9E3779B97F4A7C15ull ^ kSize;
+		const auto kMix = [&hash](const uint64_t kWord) {
+			hash = (hash ^ kWord) * 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 32;
+		};
+
+		// Eight bytes at a time, the tail is zero padded
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= kSize; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, kBytes + i, sizeof(word));
+			kMix(word);
+		}
+
+		if (i < kSize)
+		{
+			uint64_t word = 0;
+			memcpy(&word, kBytes + i, kSize - i);
+			kMix(word);
+		}
+
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+
+		return hash;
+	}
+
 	void Timer::Start()
 	{
 		_startTimestamp = std::chrono::high_resolution_clock::now();
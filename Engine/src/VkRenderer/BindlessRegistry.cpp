@@ -0,0 +1,186 @@
+#include "VkRenderer/BindlessRegistry.h"
+
+#include "Core.h"
+#include "VkRenderer/Context.h"
+#include "VkRenderer/DeletionQueue.h"
+#include "VkRenderer/Texture.h"
+
+BindlessRegistry* BindlessRegistry::_sInstance = nullptr;
+
+BindlessRegistry& BindlessRegistry::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+BindlessRegistry::BindlessRegistry()
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	_sInstance = this;
+
+	if (!IsEnabled())
+		return;
+
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+	bindings[TEXTURES] = { TEXTURES, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES, VK_SHADER_STAGE_ALL_GRAPHICS, nullptr };
+	bindings[CUBEMAPS] = { CUBEMAPS, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_CUBEMAPS, VK_SHADER_STAGE_ALL_GRAPHICS, nullptr };
+	bindings[MATERIALS] = { MATERIALS, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_ALL_GRAPHICS, nullptr };
+
+	// Textures come and go while frames using the set are in flight, the slots never written are never read
+	constexpr VkDescriptorBindingFlags kArrayFlags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+	const std::array<VkDescriptorBindingFlags, 3> kBindingFlags = { kArrayFlags, kArrayFlags, 0 };
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flagsInfo.bindingCount = static_cast<uint32_t>(kBindingFlags.size());
+	flagsInfo.pBindingFlags = kBindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &flagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	VkResult err = vkCreateDescriptorSetLayout(LogicalDevice::Instance()._device, &layoutInfo, Context::Instance()._allocator, &_layout);
+	VK_ASSERT(err, "error when creating bindless descriptor set layout");
+
+	const std::array<VkDescriptorPoolSize, 2> kPoolSizes =
+	{{
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES + MAX_CUBEMAPS },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 }
+	}};
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(kPoolSizes.size());
+	poolInfo.pPoolSizes = kPoolSizes.data();
+
+	err = vkCreateDescriptorPool(LogicalDevice::Instance()._device, &poolInfo, Context::Instance()._allocator, &_pool);
+	VK_ASSERT(err, "error when creating bindless descriptor pool");
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = _pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &_layout;
+
+	err = vkAllocateDescriptorSets(LogicalDevice::Instance()._device, &allocInfo, &_set);
+	VK_ASSERT(err, "error when allocating bindless descriptor set");
+
+	_materials = Buffer(MAX_MATERIALS * sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, Buffer::MemoryUsage::UPLOAD);
+
+	const VkDescriptorBufferInfo kMaterialsInfo = _materials.CreateDescriptorInfo();
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = MATERIALS;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &kMaterialsInfo;
+
+	vkUpdateDescriptorSets(LogicalDevice::Instance()._device, 1, &write, 0, nullptr);
+}
+
+BindlessRegistry::~BindlessRegistry()
+{
+	if (IsEnabled())
+	{
+		DeletionQueue::Push([layout = _layout, pool = _pool]() {
+			vkDestroyDescriptorPool(LogicalDevice::Instance()._device, pool, Context::Instance()._allocator);
+			vkDestroyDescriptorSetLayout(LogicalDevice::Instance()._device, layout, Context::Instance()._allocator);
+		});
+	}
+
+	_sInstance = nullptr;
+}
+
+uint32_t BindlessRegistry::AllocateIndex(std::vector<uint32_t>& freeIndices, uint32_t& count, [[maybe_unused]] const uint32_t kMax)
+{
+	if (!freeIndices.empty())
+	{
+		const uint32_t kIndex = freeIndices.back();
+		freeIndices.pop_back();
+		return kIndex;
+	}
+
+	ASSERT(count < kMax, "bindless array is full, " + std::to_string(kMax) + " elements")
+	return count++;
+}
+
+void BindlessRegistry::FreeIndex(std::vector<uint32_t>& freeIndices, const uint32_t kIndex)
+{
+	// The draws of the frames in flight may still read the slot
+	DeletionQueue::Push([&freeIndices, &mutex = _mutex, kIndex]() {
+		std::lock_guard<std::mutex> lock(mutex);
+		freeIndices.push_back(kIndex);
+	});
+}
+
+bool BindlessRegistry::IsEnabled() const
+{
+	return LogicalDevice::Instance()._descriptorIndexing;
+}
+
+uint32_t BindlessRegistry::RegisterTexture(const Texture& kTexture)
+{
+	if (!IsEnabled())
+		return INVALID_INDEX;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const bool kIsCubemap = kTexture._image._isCubemap;
+	const uint32_t kIndex = kIsCubemap ? AllocateIndex(_freeCubemaps, _cubemapCount, MAX_CUBEMAPS)
+										: AllocateIndex(_freeTextures, _textureCount, MAX_TEXTURES);
+
+	const VkDescriptorImageInfo kImageInfo = kTexture.CreateDescriptorInfo();
+
+	VkWriteDescriptorSet write{};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = kIsCubemap ? CUBEMAPS : TEXTURES;
+	write.dstArrayElement = kIndex;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &kImageInfo;
+
+	vkUpdateDescriptorSets(LogicalDevice::Instance()._device, 1, &write, 0, nullptr);
+
+	return kIndex;
+}
+
+void BindlessRegistry::UnregisterTexture(const Texture& kTexture, const uint32_t kIndex)
+{
+	if (kIndex == INVALID_INDEX)
+		return;
+
+	// The descriptor is left as is, partially bound slots are not read until written again
+	FreeIndex(kTexture._image._isCubemap ? _freeCubemaps : _freeTextures, kIndex);
+}
+
+uint32_t BindlessRegistry::RegisterMaterial(const MaterialData& kData)
+{
+	if (!IsEnabled())
+		return INVALID_INDEX;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const uint32_t kIndex = AllocateIndex(_freeMaterials, _materialCount, MAX_MATERIALS);
+
+	// The slot is unused by the frames in flight, it can be written straight away
+	_materials.Write(kData, kIndex * sizeof(MaterialData));
+	_materials.Flush();
+
+	return kIndex;
+}
+
+void BindlessRegistry::UnregisterMaterial(const uint32_t kIndex)
+{
+	if (kIndex == INVALID_INDEX)
+		return;
+
+	FreeIndex(_freeMaterials, kIndex);
+}
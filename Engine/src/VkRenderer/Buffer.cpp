@@ -1,11 +1,43 @@
 #include "VkRenderer/Buffer.h"
 
+#include <algorithm>
+
 #include "Core.h"
 #include "VkRenderer/Context.h"
 #include "VkRenderer/CommandBuffer.h"
+#include "VkRenderer/DeletionQueue.h"
+
+namespace
+{
+	uint32_t FindMemoryType(const uint32_t kTypeFilter, const Buffer::MemoryUsage kMemoryUsage)
+	{
+		const Device& kDevice = *LogicalDevice::Instance()._physicalDevice;
+
+		switch (kMemoryUsage)
+		{
+		case Buffer::MemoryUsage::DEVICE_LOCAL:
+			return kDevice.FindMemoryType(kTypeFilter, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		case Buffer::MemoryUsage::READBACK:
+		{
+			// Cached memory makes CPU reads way faster, it's often not coherent so Read invalidates it
+			constexpr VkMemoryPropertyFlags kCached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			for (uint32_t i = 0; i < kDevice._memoryProperties.memoryTypeCount; ++i)
+			{
+				if ((kTypeFilter & (1 << i)) && (kDevice._memoryProperties.memoryTypes[i].propertyFlags & kCached) == kCached)
+					return i;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+
+		return kDevice.FindMemoryType(kTypeFilter, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+}
 
-Buffer::Buffer(const VkDeviceSize kSize, const VkBufferUsageFlags kUsage)
-	: _size{ kSize }
+Buffer::Buffer(const VkDeviceSize kSize, const VkBufferUsageFlags kUsage, const MemoryUsage kMemoryUsage)
+	: _size{ kSize }, _memoryUsage{ kMemoryUsage }
 {
 	ASSERT(_size != 0u, "kSize is 0")
 
@@ -13,6 +45,8 @@ Buffer::Buffer(const VkDeviceSize kSize, const VkBufferUsageFlags kUsage)
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = kSize;
 	bufferInfo.usage = kUsage;
+	if (_memoryUsage == MemoryUsage::DEVICE_LOCAL) // only reachable through a copy
+		bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 	VkResult result = vkCreateBuffer(LogicalDevice::Instance()._device, &bufferInfo, Context::Instance()._allocator, &_buffer);
@@ -21,16 +55,10 @@ Buffer::Buffer(const VkDeviceSize kSize, const VkBufferUsageFlags kUsage)
 	VkMemoryRequirements memRequirements;
 	vkGetBufferMemoryRequirements(LogicalDevice::Instance()._device, _buffer, &memRequirements);
 
-	VkMemoryAllocateInfo allocInfo{};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.allocationSize = memRequirements.size;
-	allocInfo.memoryTypeIndex = LogicalDevice::Instance()._physicalDevice->
-									FindMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	_allocation = MemoryAllocator::Instance().Allocate(memRequirements, FindMemoryType(memRequirements.memoryTypeBits, _memoryUsage),
+														MemoryAllocator::ResourceType::LINEAR);
 
-	result = vkAllocateMemory(LogicalDevice::Instance()._device, &allocInfo, Context::Instance()._allocator, &_memory);
-	VK_ASSERT(result, "error when allocating memory");
-
-	result = vkBindBufferMemory(LogicalDevice::Instance()._device, _buffer, _memory, 0);
+	result = vkBindBufferMemory(LogicalDevice::Instance()._device, _buffer, _allocation._memory, _allocation._offset);
 	VK_ASSERT(result, "error when binding memory");
 }
 
@@ -40,11 +68,12 @@ Buffer::~Buffer()
 }
 
 Buffer::Buffer(Buffer&& buffer)
-	: _size{ buffer._size}, _buffer{ buffer._buffer }, _memory{ buffer._memory }
+	: _size{ buffer._size}, _buffer{ buffer._buffer }, _allocation{ buffer._allocation }, _memoryUsage{ buffer._memoryUsage },
+	_dirtyBegin{ buffer._dirtyBegin }, _dirtyEnd{ buffer._dirtyEnd }
 {
 	buffer._size = 0;
 	buffer._buffer = VK_NULL_HANDLE;
-	buffer._memory = VK_NULL_HANDLE;
+	buffer._allocation = Allocation{};
 }
 
 Buffer& Buffer::operator=(Buffer&& buffer)
@@ -53,34 +82,86 @@ Buffer& Buffer::operator=(Buffer&& buffer)
 
 	_size = buffer._size;
 	_buffer = buffer._buffer;
-	_memory = buffer._memory;
+	_allocation = buffer._allocation;
+	_memoryUsage = buffer._memoryUsage;
+	_dirtyBegin = buffer._dirtyBegin;
+	_dirtyEnd = buffer._dirtyEnd;
 
 	buffer._size = 0;
 	buffer._buffer = VK_NULL_HANDLE;
-	buffer._memory = VK_NULL_HANDLE;
+	buffer._allocation = Allocation{};
 
 	return *this;
 }
 
 void Buffer::Clean()
 {
-	if (_memory != VK_NULL_HANDLE)
-		vkFreeMemory(LogicalDevice::Instance()._device, _memory, Context::Instance()._allocator);
-	if (_buffer != VK_NULL_HANDLE)
-		vkDestroyBuffer(LogicalDevice::Instance()._device, _buffer, Context::Instance()._allocator);
+	if (_buffer == VK_NULL_HANDLE)
+		return;
+
+	DeletionQueue::Push([buffer = _buffer, allocation = _allocation]() mutable {
+		vkDestroyBuffer(LogicalDevice::Instance()._device, buffer, Context::Instance()._allocator);
+		MemoryAllocator::Instance().Free(allocation);
+	});
+}
+
+void Buffer::Write(const void* data, size_t size, size_t offset) const
+{
+	ASSERT(data != nullptr, "data is nullptr")
+	ASSERT(size != 0u, "size is 0")
+	ASSERT(offset < _size, "offset >= _size, writing unknown memory")
+	ASSERT((offset + size) <= _size, "(offset + size) > _size, writing unknown memory")
+	ASSERT(_allocation._mapped != nullptr, "buffer is not host visible, use Upload")
+
+	memcpy(static_cast<uint8_t*>(_allocation._mapped) + offset, data, size);
+
+	if (!_allocation._coherent)
+	{
+		_dirtyBegin = std::min<VkDeviceSize>(_dirtyBegin, offset);
+		_dirtyEnd = std::max<VkDeviceSize>(_dirtyEnd, offset + size);
+	}
+}
+
+void Buffer::Flush() const
+{
+	if (_dirtyBegin >= _dirtyEnd)
+		return;
+
+	MemoryAllocator::Instance().Flush(_allocation, _dirtyBegin, _dirtyEnd - _dirtyBegin);
+
+	_dirtyBegin = VK_WHOLE_SIZE;
+	_dirtyEnd = 0;
 }
 
-void Buffer::Map(void* data, size_t size, size_t offset) const
+void Buffer::Read(void* data, size_t size, size_t offset) const
 {
 	ASSERT(data != nullptr, "data is nullptr")
 	ASSERT(size != 0u, "size is 0")
-	ASSERT(offset < _size, "offset >= _size, mapping unknown memory")
-	ASSERT((offset + size) <= _size, "(offset + size) > _size, mapping unknown memory")
+	ASSERT((offset + size) <= _size, "(offset + size) > _size, reading unknown memory")
+	ASSERT(_allocation._mapped != nullptr, "buffer is not host visible, copy it in a readback buffer")
+
+	MemoryAllocator::Instance().Invalidate(_allocation, offset, size);
+	memcpy(data, static_cast<const uint8_t*>(_allocation._mapped) + offset, size);
+}
+
+void Buffer::Upload(const Queue& kQueue, const void* data, size_t size, size_t offset) const
+{
+	ASSERT((offset + size) <= _size, "(offset + size) > _size, uploading to unknown memory")
+
+	if (_memoryUsage != MemoryUsage::DEVICE_LOCAL)
+	{
+		Write(data, size, offset);
+		Flush();
+		return;
+	}
+
+	Buffer stagingBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::UPLOAD);
+	stagingBuffer.Write(data, size);
+	stagingBuffer.Flush();
 
-	void* memoryPtr = nullptr;
-	vkMapMemory(LogicalDevice::Instance()._device, _memory, offset, size, 0, &memoryPtr);
-	memcpy(memoryPtr, data, size);
-	vkUnmapMemory(LogicalDevice::Instance()._device, _memory);
+	CommandBuffer commandBuffer = CommandBuffer::BeginSingleTimeCommands(kQueue);
+	CopyBuffer(commandBuffer, stagingBuffer, size, 0, offset);
+	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
 }
 
 void Buffer::CopyBuffer(const Queue& kQueue, const Buffer& kSrcBuffer) const
@@ -88,12 +169,21 @@ void Buffer::CopyBuffer(const Queue& kQueue, const Buffer& kSrcBuffer) const
 	ASSERT(kSrcBuffer._size == _size, "different size src : " + std::to_string(kSrcBuffer._size) + ", dst : " + std::to_string(_size))
 
 	CommandBuffer commandBuffer = CommandBuffer::BeginSingleTimeCommands(kQueue);
+	CopyBuffer(commandBuffer, kSrcBuffer, _size);
+	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
+}
 
-	VkBufferCopy copyRegion{};
-	copyRegion.size = _size;
-	vkCmdCopyBuffer(commandBuffer, kSrcBuffer, _buffer, 1, &copyRegion);
+void Buffer::CopyBuffer(const CommandBuffer& kCommandBuffer, const Buffer& kSrcBuffer, const VkDeviceSize kSize,
+						const VkDeviceSize kSrcOffset, const VkDeviceSize kDstOffset) const
+{
+	ASSERT(kSrcOffset + kSize <= kSrcBuffer._size, "copying unknown memory from kSrcBuffer")
+	ASSERT(kDstOffset + kSize <= _size, "copying to unknown memory")
 
-	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
+	VkBufferCopy copyRegion{};
+	copyRegion.srcOffset = kSrcOffset;
+	copyRegion.dstOffset = kDstOffset;
+	copyRegion.size = kSize;
+	vkCmdCopyBuffer(kCommandBuffer, kSrcBuffer, _buffer, 1, &copyRegion);
 }
 
 const VkDescriptorBufferInfo Buffer::CreateDescriptorInfo() const
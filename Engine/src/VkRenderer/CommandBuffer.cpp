@@ -1,6 +1,7 @@
 #include "VkRenderer/CommandBuffer.h"
 
 #include "Core.h"
+#include "VkRenderer/GpuTimeline.h"
 
 CommandBuffer::CommandBuffer(const Queue& kQueue, const VkCommandBufferLevel kLevel)
 	: _commandPool { kQueue._commandPool }
@@ -21,7 +22,7 @@ CommandBuffer::~CommandBuffer()
 }
 
 CommandBuffer::CommandBuffer(CommandBuffer&& commandBuffer)
-	: _commandBuffer { commandBuffer._commandBuffer }
+	: _commandPool{ commandBuffer._commandPool }, _commandBuffer { commandBuffer._commandBuffer }
 {
 	commandBuffer._commandBuffer = VK_NULL_HANDLE;
 }
@@ -54,11 +55,8 @@ void CommandBuffer::EndSingleTimeCommands(const Queue& kQueue, const CommandBuff
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &kCommandBuffer._commandBuffer;
 
-	VkResult err = vkQueueSubmit(kQueue._queue, 1, &submitInfo, VK_NULL_HANDLE);
-	VK_ASSERT(err, "error when submitting queue");
-
-	err = vkQueueWaitIdle(kQueue._queue);
-	VK_ASSERT(err, "error when waiting idle queue");
+	const uint64_t kValue = GpuTimeline::Instance().Submit(kQueue, submitInfo);
+	GpuTimeline::Instance().Wait(kQueue, kValue);
 }
 
 void CommandBuffer::Clean()
@@ -0,0 +1,97 @@
+#include "VkRenderer/CommandRecorder.h"
+
+#include "Core.h"
+
+#include <algorithm>
+
+CommandRecorder::CommandRecorder(const CommandBuffer& kCommandBuffer)
+	: _commandBuffer{ kCommandBuffer }
+{
+}
+
+void CommandRecorder::BindPipeline(const VkPipeline kPipeline)
+{
+	if (kPipeline == _pipeline)
+	{
+		++_stats._elided;
+		return;
+	}
+
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, kPipeline);
+	_pipeline = kPipeline;
+	++_stats._binds;
+}
+
+void CommandRecorder::BindDescriptorSets(const VkPipelineLayout kLayout, ez::Span<const VkDescriptorSet> kSets,
+											ez::Span<const uint32_t> kDynamicOffsets, ez::Span<const uint32_t> kOffsetCounts)
+{
+	ASSERT(kSets.Size() <= MAX_SETS, "more than " + std::to_string(MAX_SETS) + " sets")
+	ASSERT(kOffsetCounts.Size() == kSets.Size(), "kOffsetCounts doesn't match kSets")
+	ASSERT(kDynamicOffsets.Size() <= MAX_DYNAMIC_OFFSETS, "more than " + std::to_string(MAX_DYNAMIC_OFFSETS) + " dynamic offsets")
+
+	// The materials don't share their layouts, the sets bound with another one are not kept
+	if (kLayout != _pipelineLayout)
+	{
+		_pipelineLayout = kLayout;
+		_sets.fill(VK_NULL_HANDLE);
+	}
+
+	// The sets before the first one which changed match, their offsets start at the same place in both arrays
+	size_t first = 0;
+	size_t firstOffset = 0;
+	while (first < kSets.Size() && kSets[first] == _sets[first] && kOffsetCounts[first] == _offsetCounts[first]
+		&& std::equal(kDynamicOffsets.begin() + firstOffset, kDynamicOffsets.begin() + firstOffset + kOffsetCounts[first], _dynamicOffsets.begin() + firstOffset))
+	{
+		firstOffset += kOffsetCounts[first];
+		++first;
+	}
+
+	_stats._elided += static_cast<uint32_t>(first);
+	if (first == kSets.Size())
+		return;
+
+	std::copy(kSets.begin() + first, kSets.end(), _sets.begin() + first);
+	std::copy(kOffsetCounts.begin() + first, kOffsetCounts.end(), _offsetCounts.begin() + first);
+	std::copy(kDynamicOffsets.begin() + firstOffset, kDynamicOffsets.end(), _dynamicOffsets.begin() + firstOffset);
+
+	vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, kLayout, static_cast<uint32_t>(first),
+							static_cast<uint32_t>(kSets.Size() - first), &_sets[first],
+							static_cast<uint32_t>(kDynamicOffsets.Size() - firstOffset), _dynamicOffsets.data() + firstOffset);
+	_stats._binds += static_cast<uint32_t>(kSets.Size() - first);
+}
+
+void CommandRecorder::BindIndexBuffer(const VkBuffer kBuffer, const VkDeviceSize kOffset, const VkIndexType kType)
+{
+	if (kBuffer == _indexBuffer && kOffset == _indexOffset && kType == _indexType)
+	{
+		++_stats._elided;
+		return;
+	}
+
+	vkCmdBindIndexBuffer(_commandBuffer, kBuffer, kOffset, kType);
+	_indexBuffer = kBuffer;
+	_indexOffset = kOffset;
+	_indexType = kType;
+	++_stats._binds;
+}
+
+void CommandRecorder::BindVertexBuffer(const uint32_t kBinding, const VkBuffer kBuffer, const VkDeviceSize kOffset)
+{
+	ASSERT(kBinding < MAX_VERTEX_BUFFERS, "kBinding is out of range")
+
+	if (kBuffer == _vertexBuffers[kBinding] && kOffset == _vertexOffsets[kBinding])
+	{
+		++_stats._elided;
+		return;
+	}
+
+	vkCmdBindVertexBuffers(_commandBuffer, kBinding, 1, &kBuffer, &kOffset);
+	_vertexBuffers[kBinding] = kBuffer;
+	_vertexOffsets[kBinding] = kOffset;
+	++_stats._binds;
+}
+
+CommandRecorder::operator const CommandBuffer& () const
+{
+	return _commandBuffer;
+}
@@ -0,0 +1,86 @@
+#include "VkRenderer/DeletionQueue.h"
+
+#include "Core.h"
+
+DeletionQueue* DeletionQueue::_sInstance = nullptr;
+
+DeletionQueue& DeletionQueue::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+DeletionQueue::DeletionQueue()
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	_sInstance = this;
+}
+
+DeletionQueue::~DeletionQueue()
+{
+	Flush();
+
+	_sInstance = nullptr;
+}
+
+void DeletionQueue::Push(std::function<void()>&& release)
+{
+	if (_sInstance == nullptr)
+	{
+		release();
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_sInstance->_mutex);
+	_sInstance->_frameReleases.push_back(std::move(release));
+}
+
+void DeletionQueue::Update()
+{
+	std::vector<std::function<void()>> releases;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// Everything recorded while they were released is submitted by now
+		if (!_frameReleases.empty())
+		{
+			const GpuTimeline::Point kPoint = GpuTimeline::Instance().GetSubmittedPoint();
+			for (std::function<void()>& release : _frameReleases)
+				_entries.push_back({ kPoint, std::move(release) });
+			_frameReleases.clear();
+		}
+
+		// Points only grow, the first entry still in use ends the search
+		while (!_entries.empty() && GpuTimeline::Instance().IsComplete(_entries.front()._point))
+		{
+			releases.push_back(std::move(_entries.front()._release));
+			_entries.pop_front();
+		}
+	}
+
+	for (const std::function<void()>& kRelease : releases)
+		kRelease();
+}
+
+void DeletionQueue::Flush()
+{
+	std::vector<std::function<void()>> releases;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		for (Entry& entry : _entries)
+			releases.push_back(std::move(entry._release));
+		for (std::function<void()>& release : _frameReleases)
+			releases.push_back(std::move(release));
+
+		_entries.clear();
+		_frameReleases.clear();
+	}
+
+	GpuTimeline::Instance().Wait(GpuTimeline::Instance().GetSubmittedPoint());
+
+	for (const std::function<void()>& kRelease : releases)
+		kRelease();
+}
@@ -0,0 +1,316 @@
+#include "VkRenderer/DescriptorAllocator.h"
+
+#include "Core.h"
+#include "Utils.h"
+#include "VkRenderer/Context.h"
+#include "VkRenderer/Device.h"
+#include "VkRenderer/DeletionQueue.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Descriptors of one transient set on average, most sets are a few buffers and images
+	constexpr VkDescriptorPoolSize FRAME_SET_SIZES[] =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4 },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 }
+	};
+
+	bool IsImage(const VkDescriptorType kType)
+	{
+		return kType == VK_DESCRIPTOR_TYPE_SAMPLER || kType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+			|| kType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE || kType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+			|| kType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	}
+}
+
+DescriptorAllocator* DescriptorAllocator::_sInstance = nullptr;
+
+DescriptorAllocator& DescriptorAllocator::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+DescriptorAllocator::DescriptorAllocator(const uint32_t kFrameCount)
+	: _frames{ kFrameCount }
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	ASSERT(kFrameCount > 0, "kFrameCount is 0")
+	_sInstance = this;
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	// Created before the GpuTimeline, the GPU is idle by now
+	for (const auto& kChain : _chains)
+	{
+		for (const VkDescriptorPool kPool : kChain.second._pools)
+			vkDestroyDescriptorPool(LogicalDevice::Instance()._device, kPool, Context::Instance()._allocator);
+		vkDestroyDescriptorUpdateTemplate(LogicalDevice::Instance()._device, kChain.second._template, Context::Instance()._allocator);
+	}
+
+	for (const FramePools& kFrame : _frames)
+	{
+		for (const VkDescriptorPool kPool : kFrame._pools)
+			vkDestroyDescriptorPool(LogicalDevice::Instance()._device, kPool, Context::Instance()._allocator);
+	}
+
+	_sInstance = nullptr;
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool(ez::Span<const VkDescriptorPoolSize> kSetSizes, const uint32_t kSetCount) const
+{
+	std::vector<VkDescriptorPoolSize> poolSizes(kSetSizes.begin(), kSetSizes.end());
+	for (VkDescriptorPoolSize& poolSize : poolSizes)
+		poolSize.descriptorCount *= kSetCount;
+
+	// Sets without bindings still need a size
+	if (poolSizes.empty())
+		poolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 });
+
+	VkDescriptorPoolCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	info.maxSets = kSetCount;
+	info.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	info.pPoolSizes = poolSizes.data();
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkResult err = vkCreateDescriptorPool(LogicalDevice::Instance()._device, &info, Context::Instance()._allocator, &pool);
+	VK_ASSERT(err, "error when creating descriptor pool");
+
+	return pool;
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateFromChain(const VkDescriptorSetLayout kLayout)
+{
+	const auto kIt = _chains.find(kLayout);
+	ASSERT(kIt != _chains.end(), "layout is not registered")
+	PoolChain& chain = kIt->second;
+
+	if (!chain._freeSets.empty())
+	{
+		const VkDescriptorSet kSet = chain._freeSets.back();
+		chain._freeSets.pop_back();
+		return kSet;
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &kLayout;
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	if (!chain._pools.empty())
+	{
+		allocInfo.descriptorPool = chain._pools.back();
+		if (vkAllocateDescriptorSets(LogicalDevice::Instance()._device, &allocInfo, &set) == VK_SUCCESS)
+			return set;
+	}
+
+	// The last pool is full, the next one is twice as big
+	chain._pools.push_back(CreatePool(chain._setSizes, chain._nextPoolSets));
+	chain._nextPoolSets = std::min(chain._nextPoolSets * 2, MAX_POOL_SETS);
+
+	allocInfo.descriptorPool = chain._pools.back();
+	VkResult err = vkAllocateDescriptorSets(LogicalDevice::Instance()._device, &allocInfo, &set);
+	VK_ASSERT(err, "error when allocating descriptor sets");
+
+	return set;
+}
+
+void DescriptorAllocator::RegisterLayout(const VkDescriptorSetLayout kLayout, ez::Span<const VkDescriptorSetLayoutBinding> kBindings)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	ASSERT(_chains.find(kLayout) == _chains.end(), "layout is already registered")
+	PoolChain& chain = _chains[kLayout];
+
+	std::vector<VkDescriptorUpdateTemplateEntry> entries;
+	for (const VkDescriptorSetLayoutBinding& kBinding : kBindings)
+	{
+		if (kBinding.descriptorCount == 0)
+			continue;
+
+		VkDescriptorUpdateTemplateEntry entry{};
+		entry.dstBinding = kBinding.binding;
+		entry.descriptorCount = kBinding.descriptorCount;
+		entry.descriptorType = kBinding.descriptorType;
+		entry.offset = chain._types.size() * sizeof(DescriptorInfo);
+		entry.stride = sizeof(DescriptorInfo);
+		entries.push_back(entry);
+
+		chain._types.insert(chain._types.end(), kBinding.descriptorCount, kBinding.descriptorType);
+
+		const auto kIt = std::find_if(chain._setSizes.begin(), chain._setSizes.end(),
+										[&kBinding](const VkDescriptorPoolSize& kSize) { return kSize.type == kBinding.descriptorType; });
+		if (kIt != chain._setSizes.end())
+			kIt->descriptorCount += kBinding.descriptorCount;
+		else
+			chain._setSizes.push_back({ kBinding.descriptorType, kBinding.descriptorCount });
+	}
+
+	if (entries.empty())
+		return;
+
+	VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+	templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+	templateInfo.pDescriptorUpdateEntries = entries.data();
+	templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	templateInfo.descriptorSetLayout = kLayout;
+
+	VkResult err = vkCreateDescriptorUpdateTemplate(LogicalDevice::Instance()._device, &templateInfo, Context::Instance()._allocator, &chain._template);
+	VK_ASSERT(err, "error when creating descriptor update template");
+}
+
+void DescriptorAllocator::UnregisterLayout(const VkDescriptorSetLayout kLayout)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const auto kIt = _chains.find(kLayout);
+	ASSERT(kIt != _chains.end(), "layout is not registered")
+
+	for (const VkDescriptorPool kPool : kIt->second._pools)
+		vkDestroyDescriptorPool(LogicalDevice::Instance()._device, kPool, Context::Instance()._allocator);
+	vkDestroyDescriptorUpdateTemplate(LogicalDevice::Instance()._device, kIt->second._template, Context::Instance()._allocator);
+
+	_chains.erase(kIt);
+}
+
+VkDescriptorSet DescriptorAllocator::Acquire(const VkDescriptorSetLayout kLayout, ez::Span<const DescriptorInfo> kInfos)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const auto kChainIt = _chains.find(kLayout);
+	ASSERT(kChainIt != _chains.end(), "layout is not registered")
+	const PoolChain& kChain = kChainIt->second;
+	ASSERT(kInfos.Empty() || kInfos.Size() == kChain._types.size(), "set needs " + std::to_string(kChain._types.size()) + " descriptors")
+
+	// What the set holds, read field by field: the padding of the infos is left undefined
+	std::vector<uint64_t> key{ (uint64_t)kLayout };
+	for (size_t i = 0; i < kInfos.Size(); ++i)
+	{
+		if (IsImage(kChain._types[i]))
+		{
+			key.push_back((uint64_t)kInfos[i]._image.sampler);
+			key.push_back((uint64_t)kInfos[i]._image.imageView);
+			key.push_back(kInfos[i]._image.imageLayout);
+		}
+		else
+		{
+			key.push_back((uint64_t)kInfos[i]._buffer.buffer);
+			key.push_back(kInfos[i]._buffer.offset);
+			key.push_back(kInfos[i]._buffer.range);
+		}
+	}
+	const uint64_t kHash = ez::HashBytes(key.data(), key.size() * sizeof(uint64_t));
+
+	CachedSet& cached = _cache[kHash];
+	if (cached._set != VK_NULL_HANDLE)
+	{
+		ASSERT(cached._key == key, "descriptor set key collides with another set")
+		++cached._references;
+		return cached._set;
+	}
+
+	cached._key = std::move(key);
+	cached._layout = kLayout;
+	cached._set = AllocateFromChain(kLayout);
+	cached._references = 1;
+	_cacheKeys[cached._set] = kHash;
+
+	if (!kInfos.Empty())
+		vkUpdateDescriptorSetWithTemplate(LogicalDevice::Instance()._device, cached._set, kChain._template, kInfos.Data());
+
+	return cached._set;
+}
+
+void DescriptorAllocator::Release(const VkDescriptorSet kSet)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const auto kKeyIt = _cacheKeys.find(kSet);
+	ASSERT(kKeyIt != _cacheKeys.end(), "set was not acquired")
+
+	const auto kIt = _cache.find(kKeyIt->second);
+	if (--kIt->second._references > 0)
+		return;
+
+	// Out of the cache straight away, the set can only be rewritten once the GPU is done with it
+	DeletionQueue::Push([kSet, layout = kIt->second._layout]() {
+		std::lock_guard<std::mutex> lock(Instance()._mutex);
+
+		const auto kChainIt = Instance()._chains.find(layout);
+		if (kChainIt != Instance()._chains.end())
+			kChainIt->second._freeSets.push_back(kSet);
+	});
+
+	_cache.erase(kIt);
+	_cacheKeys.erase(kKeyIt);
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateTransient(const VkDescriptorSetLayout kLayout, ez::Span<const DescriptorInfo> kInfos)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	FramePools& frame = _frames[_frameIndex];
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &kLayout;
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	for (; frame._current < frame._pools.size(); ++frame._current)
+	{
+		allocInfo.descriptorPool = frame._pools[frame._current];
+		if (vkAllocateDescriptorSets(LogicalDevice::Instance()._device, &allocInfo, &set) == VK_SUCCESS)
+			break;
+	}
+
+	if (set == VK_NULL_HANDLE)
+	{
+		// Kept for the next frames, the pools of a frame only grow
+		frame._pools.push_back(CreatePool(FRAME_SET_SIZES, FRAME_POOL_SETS));
+
+		allocInfo.descriptorPool = frame._pools.back();
+		VkResult err = vkAllocateDescriptorSets(LogicalDevice::Instance()._device, &allocInfo, &set);
+		VK_ASSERT(err, "error when allocating transient descriptor set");
+	}
+
+	if (!kInfos.Empty())
+	{
+		const auto kChainIt = _chains.find(kLayout);
+		ASSERT(kChainIt != _chains.end(), "layout is not registered")
+		ASSERT(kInfos.Size() == kChainIt->second._types.size(), "set needs " + std::to_string(kChainIt->second._types.size()) + " descriptors")
+
+		vkUpdateDescriptorSetWithTemplate(LogicalDevice::Instance()._device, set, kChainIt->second._template, kInfos.Data());
+	}
+
+	return set;
+}
+
+void DescriptorAllocator::Update()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Everything allocated during the frame is recorded in submitted work by now
+	_frames[_frameIndex]._point = GpuTimeline::Instance().GetSubmittedPoint();
+	_frameIndex = (_frameIndex + 1) % _frames.size();
+
+	// Nothing was ever allocated in the frame, there is nothing to wait for
+	FramePools& frame = _frames[_frameIndex];
+	if (frame._pools.empty())
+		return;
+
+	GpuTimeline::Instance().Wait(frame._point);
+
+	for (const VkDescriptorPool kPool : frame._pools)
+		vkResetDescriptorPool(LogicalDevice::Instance()._device, kPool, 0);
+	frame._current = 0;
+}
@@ -1,9 +1,27 @@
 #include "VkRenderer/Device.h"
 
 #include "Core.h"
+#include "MappedFile.h"
 #include "VkRenderer/Context.h"
 
 #include <map>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+	// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, at the start of any pipeline cache data
+	struct PipelineCacheHeader
+	{
+		uint32_t	_headerSize;
+		uint32_t	_headerVersion;
+		uint32_t	_vendorID;
+		uint32_t	_deviceID;
+		uint8_t		_pipelineCacheUUID[VK_UUID_SIZE];
+	};
+}
 
 uint32_t Device::RateDeviceSuitability(const VkPhysicalDevice& kDevice)
 {
@@ -12,6 +30,14 @@ uint32_t Device::RateDeviceSuitability(const VkPhysicalDevice& kDevice)
 	vkGetPhysicalDeviceProperties(kDevice, &deviceProperties);
 	vkGetPhysicalDeviceFeatures(kDevice, &deviceFeatures);
 
+	VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+	timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+	VkPhysicalDeviceFeatures2 deviceFeatures2{};
+	deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	deviceFeatures2.pNext = &timelineFeatures;
+	vkGetPhysicalDeviceFeatures2(kDevice, &deviceFeatures2);
+
 	uint32_t score = 0;
 
 	// Discrete GPUs have a significant performance advantage
@@ -27,6 +53,11 @@ uint32_t Device::RateDeviceSuitability(const VkPhysicalDevice& kDevice)
 		return 0;
 	}
 
+	// GPU work is tracked with timeline semaphores
+	if (deviceProperties.apiVersion < VK_API_VERSION_1_2 || !timelineFeatures.timelineSemaphore) {
+		return 0;
+	}
+
 	return score;
 }
 
@@ -78,6 +109,11 @@ Device::Device()
 	}
 }
 
+bool Device::IsExtensionSupported(const std::string& kName) const
+{
+	return std::find(_supportedExtensions.begin(), _supportedExtensions.end(), kName) != _supportedExtensions.end();
+}
+
 uint32_t Device::FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags properties) const
 {
 	for (uint32_t i = 0; i < _memoryProperties.memoryTypeCount; i++) {
@@ -124,8 +160,8 @@ const LogicalDevice& LogicalDevice::Instance()
 	return *_sInstance;
 }
 
-LogicalDevice::LogicalDevice(const Device& kDevice)
-	: _physicalDevice { &kDevice }
+LogicalDevice::LogicalDevice(const Device& kDevice, const std::string& kPipelineCachePath)
+	: _physicalDevice { &kDevice }, _pipelineCachePath{ kPipelineCachePath }
 {
 	_sInstance = this;
 
@@ -196,8 +232,60 @@ LogicalDevice::LogicalDevice(const Device& kDevice)
 	// Enable the debug marker extension if it is present (likely meaning a debugging tool is present)
 	//deviceExtensions.push_back(VK_EXT_DEBUG_MARKER_EXTENSION_NAME); // dunno
 
+	VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+	timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	timelineFeatures.timelineSemaphore = VK_TRUE;
+
+	// Optional, a pipeline created from identifiers fails instead of compiling when it's not in the cache
+	VkPhysicalDevicePipelineCreationCacheControlFeatures cacheControlFeatures{};
+	cacheControlFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_CREATION_CACHE_CONTROL_FEATURES;
+
+	VkPhysicalDeviceShaderModuleIdentifierFeaturesEXT identifierFeatures{};
+	identifierFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_MODULE_IDENTIFIER_FEATURES_EXT;
+	identifierFeatures.pNext = &cacheControlFeatures;
+
+	if (kDevice.IsExtensionSupported(VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME)
+		&& kDevice.IsExtensionSupported(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME))
+	{
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &identifierFeatures;
+		vkGetPhysicalDeviceFeatures2(kDevice._physicalDevice, &features);
+
+		_shaderModuleIdentifier = identifierFeatures.shaderModuleIdentifier && cacheControlFeatures.pipelineCreationCacheControl;
+	}
+
+	if (_shaderModuleIdentifier)
+	{
+		deviceExtensions.emplace_back(VK_EXT_PIPELINE_CREATION_CACHE_CONTROL_EXTENSION_NAME);
+		deviceExtensions.emplace_back(VK_EXT_SHADER_MODULE_IDENTIFIER_EXTENSION_NAME);
+		timelineFeatures.pNext = &identifierFeatures;
+	}
+
+	// Optional, core since 1.2: textures are indexed in one array updated while bound
+	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	{
+		VkPhysicalDeviceFeatures2 features{};
+		features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext = &indexingFeatures;
+		vkGetPhysicalDeviceFeatures2(kDevice._physicalDevice, &features);
+
+		_descriptorIndexing = indexingFeatures.runtimeDescriptorArray && indexingFeatures.descriptorBindingPartiallyBound
+			&& indexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+	}
+
+	// Only what the bindless set needs is enabled
+	VkPhysicalDeviceDescriptorIndexingFeatures enabledIndexingFeatures{};
+	enabledIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+	enabledIndexingFeatures.pNext = &timelineFeatures;
+	enabledIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+	enabledIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+	enabledIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.pNext = _descriptorIndexing ? static_cast<void*>(&enabledIndexingFeatures) : static_cast<void*>(&timelineFeatures);
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());;
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 	deviceCreateInfo.pEnabledFeatures = &kDevice._features;
@@ -278,10 +366,15 @@ LogicalDevice::LogicalDevice(const Device& kDevice)
 		err = vkCreateDescriptorPool(_device, &pool_info, Context::Instance()._allocator, &_descriptorPool);
 		VK_ASSERT(err, "error when creating descriptor pool");
 	}
+
+	CreatePipelineCache();
 }
 
 LogicalDevice::~LogicalDevice()
 {
+	SavePipelineCache();
+	vkDestroyPipelineCache(_device, _pipelineCache, Context::Instance()._allocator);
+
 	vkDestroyDescriptorPool(_device, _descriptorPool, Context::Instance()._allocator);
 	vkDestroyCommandPool(_device, _graphicsQueue._commandPool, Context::Instance()._allocator);
 
@@ -292,4 +385,69 @@ LogicalDevice::~LogicalDevice()
 		vkDestroyCommandPool(_device, _transferQueue._commandPool, Context::Instance()._allocator);
 
 	vkDestroyDevice(_device, Context::Instance()._allocator);
-}
\ No newline at end of file
+}
+
+bool LogicalDevice::IsPipelineCacheValid(const void* kData, const size_t kSize) const
+{
+	if (kSize < sizeof(PipelineCacheHeader))
+		return false;
+
+	PipelineCacheHeader header;
+	memcpy(&header, kData, sizeof(PipelineCacheHeader));
+
+	// Data from another driver or GPU would be ignored at best
+	return header._headerSize >= sizeof(PipelineCacheHeader) && header._headerSize <= kSize
+		&& header._headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+		&& header._vendorID == _physicalDevice->_properties.vendorID
+		&& header._deviceID == _physicalDevice->_properties.deviceID
+		&& memcmp(header._pipelineCacheUUID, _physicalDevice->_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void LogicalDevice::CreatePipelineCache()
+{
+	ez::MappedFile file(_pipelineCachePath);
+
+	VkPipelineCacheCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	if (file.IsOpen() && IsPipelineCacheValid(file.Data(), file.Size()))
+	{
+		info.initialDataSize = file.Size();
+		info.pInitialData = file.Data();
+	}
+	else if (file.IsOpen())
+		LOG(ez::INFO, "Pipeline cache " + _pipelineCachePath + " was made for another device or driver, starting empty")
+
+	VkResult err = vkCreatePipelineCache(_device, &info, Context::Instance()._allocator, &_pipelineCache);
+	VK_ASSERT(err, "error when creating pipeline cache");
+}
+
+void LogicalDevice::SavePipelineCache() const
+{
+	size_t size = 0;
+	VkResult err = vkGetPipelineCacheData(_device, _pipelineCache, &size, nullptr);
+	VK_ASSERT(err, "error when getting pipeline cache data");
+
+	std::vector<char> data(size);
+	err = vkGetPipelineCacheData(_device, _pipelineCache, &size, data.data());
+	VK_ASSERT(err, "error when getting pipeline cache data");
+
+	// Written aside then renamed over the old one, a crash while saving leaves either cache whole
+	const std::string kTempPath = _pipelineCachePath + ".tmp";
+	{
+		std::ofstream file(kTempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			LOG(ez::WARNING, "Failed to write pipeline cache " + _pipelineCachePath)
+			return;
+		}
+
+		file.write(data.data(), static_cast<std::streamsize>(size));
+	}
+
+	// Replaces an existing cache on every platform, std::rename fails on Windows when the target exists
+	std::error_code error;
+	std::filesystem::rename(kTempPath, _pipelineCachePath, error);
+	if (error)
+		LOG(ez::WARNING, "Failed to write pipeline cache " + _pipelineCachePath + ": " + error.message())
+}
@@ -0,0 +1,175 @@
+#include "VkRenderer/GpuTimeline.h"
+
+#include <vector>
+
+#include "Core.h"
+#include "VkRenderer/Context.h"
+
+GpuTimeline* GpuTimeline::_sInstance = nullptr;
+
+GpuTimeline& GpuTimeline::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+GpuTimeline::GpuTimeline()
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	_sInstance = this;
+
+	VkSemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	info.pNext = &typeInfo;
+
+	for (VkSemaphore& semaphore : _semaphores)
+	{
+		VkResult err = vkCreateSemaphore(LogicalDevice::Instance()._device, &info, Context::Instance()._allocator, &semaphore);
+		VK_ASSERT(err, "error when creating semaphore");
+	}
+}
+
+GpuTimeline::~GpuTimeline()
+{
+	Wait(GetSubmittedPoint());
+
+	for (VkSemaphore semaphore : _semaphores)
+		vkDestroySemaphore(LogicalDevice::Instance()._device, semaphore, Context::Instance()._allocator);
+
+	_sInstance = nullptr;
+}
+
+size_t GpuTimeline::GetIndex(const Queue& kQueue)
+{
+	const LogicalDevice& kLogicalDevice = LogicalDevice::Instance();
+
+	if (&kQueue == &kLogicalDevice._graphicsQueue)
+		return static_cast<size_t>(QueueType::GRAPHICS);
+	if (&kQueue == &kLogicalDevice._computeQueue)
+		return static_cast<size_t>(QueueType::COMPUTE);
+
+	ASSERT(&kQueue == &kLogicalDevice._transferQueue, "kQueue is not a queue of the logical device")
+	return static_cast<size_t>(QueueType::TRANSFER);
+}
+
+uint64_t GpuTimeline::GetCompletedValue(const size_t kIndex) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Nothing left to read back once the semaphore caught up with the submissions
+	if (_completed[kIndex] == _submitted[kIndex])
+		return _completed[kIndex];
+
+	uint64_t value = 0;
+	VkResult err = vkGetSemaphoreCounterValue(LogicalDevice::Instance()._device, _semaphores[kIndex], &value);
+	VK_ASSERT(err, "error when getting semaphore counter value");
+
+	_completed[kIndex] = value;
+	return value;
+}
+
+uint64_t GpuTimeline::Submit(const Queue& kQueue, const VkSubmitInfo& kSubmitInfo, ez::Span<const WaitInfo> kWaits)
+{
+	ASSERT(kSubmitInfo.pNext == nullptr, "kSubmitInfo.pNext is already used")
+
+	const size_t kIndex = GetIndex(kQueue);
+
+	// Binary semaphores take a value of 0, it is ignored
+	std::vector<VkSemaphore> waitSemaphores(kSubmitInfo.pWaitSemaphores, kSubmitInfo.pWaitSemaphores + kSubmitInfo.waitSemaphoreCount);
+	std::vector<VkPipelineStageFlags> waitStages(kSubmitInfo.pWaitDstStageMask, kSubmitInfo.pWaitDstStageMask + kSubmitInfo.waitSemaphoreCount);
+	std::vector<uint64_t> waitValues(kSubmitInfo.waitSemaphoreCount, 0);
+
+	for (const WaitInfo& kWait : kWaits)
+	{
+		waitSemaphores.push_back(_semaphores[GetIndex(*kWait._queue)]);
+		waitStages.push_back(kWait._stage);
+		waitValues.push_back(kWait._value);
+	}
+
+	std::vector<VkSemaphore> signalSemaphores(kSubmitInfo.pSignalSemaphores, kSubmitInfo.pSignalSemaphores + kSubmitInfo.signalSemaphoreCount);
+	std::vector<uint64_t> signalValues(kSubmitInfo.signalSemaphoreCount, 0);
+
+	signalSemaphores.push_back(_semaphores[kIndex]);
+
+	// The value is taken with the submission so the values reach the queue in order
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const uint64_t kValue = _submitted[kIndex] + 1;
+	signalValues.push_back(kValue);
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo submitInfo = kSubmitInfo;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+	submitInfo.pWaitSemaphores = waitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitStages.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+	submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+	VkResult err = vkQueueSubmit(kQueue._queue, 1, &submitInfo, VK_NULL_HANDLE);
+	VK_ASSERT(err, "error when submitting queue");
+
+	_submitted[kIndex] = kValue;
+	return kValue;
+}
+
+uint64_t GpuTimeline::GetCompletedValue(const Queue& kQueue) const
+{
+	return GetCompletedValue(GetIndex(kQueue));
+}
+
+bool GpuTimeline::IsComplete(const Queue& kQueue, const uint64_t kValue) const
+{
+	return GetCompletedValue(GetIndex(kQueue)) >= kValue;
+}
+
+bool GpuTimeline::IsComplete(const Point& kPoint) const
+{
+	for (size_t i = 0; i < kPoint.size(); ++i)
+	{
+		if (GetCompletedValue(i) < kPoint[i])
+			return false;
+	}
+
+	return true;
+}
+
+void GpuTimeline::Wait(const Queue& kQueue, const uint64_t kValue) const
+{
+	Point point{};
+	point[GetIndex(kQueue)] = kValue;
+
+	Wait(point);
+}
+
+void GpuTimeline::Wait(const Point& kPoint) const
+{
+	if (IsComplete(kPoint))
+		return;
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = static_cast<uint32_t>(_semaphores.size());
+	waitInfo.pSemaphores = _semaphores.data();
+	waitInfo.pValues = kPoint.data();
+
+	VkResult err = vkWaitSemaphores(LogicalDevice::Instance()._device, &waitInfo, UINT64_MAX);
+	VK_ASSERT(err, "error when waiting for semaphores");
+}
+
+GpuTimeline::Point GpuTimeline::GetSubmittedPoint() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _submitted;
+}
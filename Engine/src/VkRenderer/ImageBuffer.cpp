@@ -3,6 +3,7 @@
 #include "Core.h"
 #include "VkRenderer/Context.h"
 #include "VkRenderer/CommandBuffer.h"
+#include "VkRenderer/DeletionQueue.h"
 
 ImageBuffer::ImageBuffer(const VkImage kImage, const VkFormat kFormat, const VkExtent2D& kExtent, const VkImageUsageFlags kUsage)
 	: _size{ kExtent }, _image{ kImage }
@@ -37,20 +38,14 @@ ImageBuffer::ImageBuffer(const VkFormat kFormat, const VkExtent2D& kExtent, cons
 	VkResult err = vkCreateImage(LogicalDevice::Instance()._device, &image, Context::Instance()._allocator, &_image);
 	VK_ASSERT(err, "error when creating image");
 
-	VkMemoryAllocateInfo memAlloc{};
 	VkMemoryRequirements memReqs;
 	vkGetImageMemoryRequirements(LogicalDevice::Instance()._device, _image, &memReqs);
 
-	memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memAlloc.allocationSize = memReqs.size;
-
-	memAlloc.memoryTypeIndex = LogicalDevice::Instance()._physicalDevice->
+	const uint32_t kMemoryType = LogicalDevice::Instance()._physicalDevice->
 									FindMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	_allocation = MemoryAllocator::Instance().Allocate(memReqs, kMemoryType, MemoryAllocator::ResourceType::OPTIMAL);
 
-	err = vkAllocateMemory(LogicalDevice::Instance()._device, &memAlloc, Context::Instance()._allocator, &_memory);
-	VK_ASSERT(err, "error when allocating memory");
-
-	err = vkBindImageMemory(LogicalDevice::Instance()._device, _image, _memory, 0);
+	err = vkBindImageMemory(LogicalDevice::Instance()._device, _image, _allocation._memory, _allocation._offset);
 	VK_ASSERT(err, "error when binding image memory");
 
 	CreateView(kFormat, kUsage);
@@ -62,10 +57,10 @@ ImageBuffer::~ImageBuffer()
 }
 
 ImageBuffer::ImageBuffer(ImageBuffer&& imageBuffer)
-	: _size{ imageBuffer._size }, _memory { imageBuffer._memory }, _image{ imageBuffer._image }, _view{ imageBuffer._view },
+	: _size{ imageBuffer._size }, _allocation{ imageBuffer._allocation }, _image{ imageBuffer._image }, _view{ imageBuffer._view },
 		_isCubemap { imageBuffer._isCubemap }
 {
-	imageBuffer._memory = VK_NULL_HANDLE;
+	imageBuffer._allocation = Allocation{};
 	imageBuffer._image = VK_NULL_HANDLE;
 	imageBuffer._view = VK_NULL_HANDLE;
 }
@@ -75,12 +70,12 @@ ImageBuffer& ImageBuffer::operator=(ImageBuffer&& imageBuffer)
 	Clean();
 
 	_size = imageBuffer._size;
-	_memory = imageBuffer._memory;
+	_allocation = imageBuffer._allocation;
 	_image = imageBuffer._image;
 	_view = imageBuffer._view;
 	_isCubemap = imageBuffer._isCubemap;
 
-	imageBuffer._memory = VK_NULL_HANDLE;
+	imageBuffer._allocation = Allocation{};
 	imageBuffer._image = VK_NULL_HANDLE;
 	imageBuffer._view = VK_NULL_HANDLE;
 
@@ -119,22 +114,45 @@ void ImageBuffer::CreateView(const VkFormat kFormat, const VkImageUsageFlags kUs
 
 void ImageBuffer::Clean()
 {
-	if (_view != VK_NULL_HANDLE)
-		vkDestroyImageView(LogicalDevice::Instance()._device, _view, Context::Instance()._allocator);
-
-	if (_memory != VK_NULL_HANDLE)
-	{
-		vkFreeMemory(LogicalDevice::Instance()._device, _memory, Context::Instance()._allocator);
-		if (_image != VK_NULL_HANDLE)
-			vkDestroyImage(LogicalDevice::Instance()._device, _image, Context::Instance()._allocator);
-	}
+	if (_view == VK_NULL_HANDLE && _image == VK_NULL_HANDLE)
+		return;
+
+	DeletionQueue::Push([view = _view, image = _image, allocation = _allocation]() mutable {
+		if (view != VK_NULL_HANDLE)
+			vkDestroyImageView(LogicalDevice::Instance()._device, view, Context::Instance()._allocator);
+
+		// Images without allocation belong to the swapchain
+		if (allocation._memory != VK_NULL_HANDLE)
+		{
+			if (image != VK_NULL_HANDLE)
+				vkDestroyImage(LogicalDevice::Instance()._device, image, Context::Instance()._allocator);
+			MemoryAllocator::Instance().Free(allocation);
+		}
+	});
 }
 
-void ImageBuffer::TransitionLayout(const Queue& kQueue, const VkImageLayout kOldLayout, const VkImageLayout kNewLayout) const
+VkImageSubresourceRange ImageBuffer::GetSubresourceRange() const
 {
-	ASSERT(kOldLayout != kNewLayout, "kOldLayout is equal to kNewLayout")
+	VkImageSubresourceRange range{};
+	range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = 1;
+	range.baseArrayLayer = 0;
+	range.layerCount = _isCubemap ? 6 : 1;
+
+	return range;
+}
 
+void ImageBuffer::TransitionLayout(const Queue& kQueue, const VkImageLayout kOldLayout, const VkImageLayout kNewLayout) const
+{
 	CommandBuffer commandBuffer = CommandBuffer::BeginSingleTimeCommands(kQueue);
+	TransitionLayout(commandBuffer, kOldLayout, kNewLayout);
+	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
+}
+
+void ImageBuffer::TransitionLayout(const CommandBuffer& kCommandBuffer, const VkImageLayout kOldLayout, const VkImageLayout kNewLayout) const
+{
+	ASSERT(kOldLayout != kNewLayout, "kOldLayout is equal to kNewLayout")
 
 	VkImageMemoryBarrier barrier{};
 	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -145,11 +163,7 @@ void ImageBuffer::TransitionLayout(const Queue& kQueue, const VkImageLayout kOld
 	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
 	barrier.image = _image;
-	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = _isCubemap ? 6 : 1;
+	barrier.subresourceRange = GetSubresourceRange();
 
 	VkPipelineStageFlags sourceStage;
 	VkPipelineStageFlags destinationStage;
@@ -173,21 +187,24 @@ void ImageBuffer::TransitionLayout(const Queue& kQueue, const VkImageLayout kOld
 	}
 
 	vkCmdPipelineBarrier(
-		commandBuffer,
+		kCommandBuffer,
 		sourceStage, destinationStage,
 		0,
 		0, nullptr,
 		0, nullptr,
 		1, &barrier
 	);
-
-	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
 }
 
 void ImageBuffer::CopyBuffer(const Queue& kQueue, const Buffer& kBuffer) const
 {
 	CommandBuffer commandBuffer = CommandBuffer::BeginSingleTimeCommands(kQueue);
+	CopyBuffer(commandBuffer, kBuffer);
+	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
+}
 
+void ImageBuffer::CopyBuffer(const CommandBuffer& kCommandBuffer, const Buffer& kBuffer) const
+{
 	VkBufferImageCopy region{};
 	region.bufferOffset = 0;
 	region.bufferRowLength = 0;
@@ -206,13 +223,11 @@ void ImageBuffer::CopyBuffer(const Queue& kQueue, const Buffer& kBuffer) const
 	};
 
 	vkCmdCopyBufferToImage(
-		commandBuffer,
+		kCommandBuffer,
 		kBuffer,
 		_image,
 		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		1,
 		&region
 	);
-
-	CommandBuffer::EndSingleTimeCommands(kQueue, commandBuffer);
 }
\ No newline at end of file
@@ -1,26 +1,163 @@
 #include "VkRenderer/Material.h"
 
 #include "VkRenderer/Context.h"
+#include "VkRenderer/DeletionQueue.h"
+#include "VkRenderer/DescriptorAllocator.h"
+#include "VkRenderer/BindlessRegistry.h"
+#include "VkRenderer/ShaderLibrary.h"
 
 #include "Core.h"
+#include "Utils.h"
+#include "ThreadPool.h"
 
-VkShaderModule loadShader(std::string path)
+#include <cmath>
+#include <algorithm>
+
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+	VkDescriptorType GetDescriptorType(const Bindings::Type kType)
+	{
+		switch (kType)
+		{
+		case Bindings::Type::BUFFER:
+			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		case Bindings::Type::DYNAMIC_BUFFER:
+			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		default:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		}
+	}
+
+	// Materials only bind uniform buffers and combined image samplers
+	bool IsCompatible(const Bindings::Type kType, const VkDescriptorType kReflectedType)
+	{
+		if (kReflectedType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			return kType == Bindings::Type::BUFFER || kType == Bindings::Type::DYNAMIC_BUFFER;
+		return kType == Bindings::Type::SAMPLER && kReflectedType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	}
+
+	// Attributes keep their location whatever the other attributes, shaders don't depend on the vertex layout
+	uint32_t GetLocation(const Vertex::DataFlag kFlag)
+	{
+		uint32_t location = 0;
+		while ((1 << location) != kFlag)
+			++location;
+		return location;
+	}
+
+	// Octahedral mapping of a direction on [-1, 1]^2, see "A Survey of Efficient Representations for Independent Unit Vectors"
+	Vec2 OctEncode(const Vec3& kDirection)
+	{
+		const float kL1Norm = std::abs(kDirection.x) + std::abs(kDirection.y) + std::abs(kDirection.z);
+		if (kL1Norm == 0.f)
+			return { 0.f, 0.f };
+
+		Vec2 encoded{ kDirection.x / kL1Norm, kDirection.y / kL1Norm };
+		if (kDirection.z < 0.f)
+		{
+			encoded = { (1.f - std::abs(encoded.y)) * (encoded.x >= 0.f ? 1.f : -1.f),
+						(1.f - std::abs(encoded.x)) * (encoded.y >= 0.f ? 1.f : -1.f) };
+		}
+
+		return encoded;
+	}
+}
+
+VertexPosition::VertexPosition(const Vertex& kVertex)
+	: pos{ kVertex.pos }
+{
+}
+
+VertexAttributes::VertexAttributes(const Vertex& kVertex)
+	: uv{ kVertex.uv }, normal{ kVertex.normal }, tangent{ kVertex.tangent }
+{
+}
+
+CompactVertexPosition::CompactVertexPosition(const Vertex& kVertex, const Vec3& kOffset, const float kScale)
+{
+	const Vec3 kPos = (kVertex.pos - kOffset) / kScale;
+	pos[0] = static_cast<int16_t>(glm::packSnorm1x16(kPos.x));
+	pos[1] = static_cast<int16_t>(glm::packSnorm1x16(kPos.y));
+	pos[2] = static_cast<int16_t>(glm::packSnorm1x16(kPos.z));
+	pos[3] = static_cast<int16_t>(glm::packSnorm1x16(1.f));
+}
+
+CompactVertexAttributes::CompactVertexAttributes(const Vertex& kVertex)
+{
+	uv[0] = glm::packHalf1x16(kVertex.uv.x);
+	uv[1] = glm::packHalf1x16(kVertex.uv.y);
+
+	const Vec2 kNormal = OctEncode(kVertex.normal);
+	normal[0] = static_cast<int16_t>(glm::packSnorm1x16(kNormal.x));
+	normal[1] = static_cast<int16_t>(glm::packSnorm1x16(kNormal.y));
+
+	const Vec2 kTangent = OctEncode(kVertex.tangent);
+	tangent[0] = static_cast<int16_t>(glm::packSnorm1x16(kTangent.x));
+	tangent[1] = static_cast<int16_t>(glm::packSnorm1x16(kTangent.y));
+}
+
+std::vector<VkVertexInputBindingDescription> Vertex::getBindingDescriptions(int kDataFlags, Format kFormat)
+{
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+
+	const bool kCompact = kFormat == Format::COMPACT;
+
+	if (kDataFlags & DataFlag::POSITION)
+	{
+		const uint32_t kStride = kCompact ? sizeof(CompactVertexPosition) : sizeof(VertexPosition);
+		bindingDescriptions.push_back({ POSITION_STREAM, kStride, VK_VERTEX_INPUT_RATE_VERTEX });
+	}
+
+	if (kDataFlags & ATTRIBUTE_FLAGS)
+	{
+		const uint32_t kStride = kCompact ? sizeof(CompactVertexAttributes) : sizeof(VertexAttributes);
+		bindingDescriptions.push_back({ ATTRIBUTE_STREAM, kStride, VK_VERTEX_INPUT_RATE_VERTEX });
+	}
+
+	return bindingDescriptions;
+}
+
+std::vector<VkVertexInputAttributeDescription> Vertex::getAttributeDescriptions(int kDataFlags, Format kFormat)
 {
-	ASSERT(!path.empty(), "path is empty")
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
-	std::vector<char> code = readFile(path);
+	const bool kCompact = kFormat == Format::COMPACT;
 
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+	if (kDataFlags & DataFlag::POSITION)
+	{
+		if (kCompact)
+			attributeDescriptions.push_back({ GetLocation(DataFlag::POSITION), POSITION_STREAM, VK_FORMAT_R16G16B16A16_SNORM, offsetof(CompactVertexPosition, pos) });
+		else
+			attributeDescriptions.push_back({ GetLocation(DataFlag::POSITION), POSITION_STREAM, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexPosition, pos) });
+	}
+
+	if (kDataFlags & DataFlag::UV)
+	{
+		if (kCompact)
+			attributeDescriptions.push_back({ GetLocation(DataFlag::UV), ATTRIBUTE_STREAM, VK_FORMAT_R16G16_SFLOAT, offsetof(CompactVertexAttributes, uv) });
+		else
+			attributeDescriptions.push_back({ GetLocation(DataFlag::UV), ATTRIBUTE_STREAM, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexAttributes, uv) });
+	}
 
-	VkShaderModule shaderModule;
+	if (kDataFlags & DataFlag::NORMAL)
+	{
+		if (kCompact)
+			attributeDescriptions.push_back({ GetLocation(DataFlag::NORMAL), ATTRIBUTE_STREAM, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertexAttributes, normal) });
+		else
+			attributeDescriptions.push_back({ GetLocation(DataFlag::NORMAL), ATTRIBUTE_STREAM, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexAttributes, normal) });
+	}
 
-	VkResult err = vkCreateShaderModule(LogicalDevice::Instance()._device, &createInfo, Context::Instance()._allocator, &shaderModule);
-	VK_ASSERT(err, "error when creating shader module");
+	if (kDataFlags & DataFlag::TANGENT)
+	{
+		if (kCompact)
+			attributeDescriptions.push_back({ GetLocation(DataFlag::TANGENT), ATTRIBUTE_STREAM, VK_FORMAT_R16G16_SNORM, offsetof(CompactVertexAttributes, tangent) });
+		else
+			attributeDescriptions.push_back({ GetLocation(DataFlag::TANGENT), ATTRIBUTE_STREAM, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexAttributes, tangent) });
+	}
 
-	return shaderModule;
+	return attributeDescriptions;
 }
 
 VkPipelineShaderStageCreateInfo createShader(VkShaderModule shaderModule, VkShaderStageFlagBits flags)
@@ -35,41 +172,181 @@ VkPipelineShaderStageCreateInfo createShader(VkShaderModule shaderModule, VkShad
 	return shaderStageInfo;
 }
 
+Specialization& Specialization::Set(const uint32_t kId, const uint32_t kValue)
+{
+	const auto kIt = std::lower_bound(_constants.begin(), _constants.end(), kId,
+										[](const Constant& kConstant, const uint32_t kId) { return kConstant._id < kId; });
+	if (kIt != _constants.end() && kIt->_id == kId)
+		kIt->_value = kValue;
+	else
+		_constants.insert(kIt, { kId, kValue });
+
+	return *this;
+}
+
+Specialization& Specialization::Set(const uint32_t kId, const bool kValue)
+{
+	return Set(kId, static_cast<uint32_t>(kValue ? VK_TRUE : VK_FALSE));
+}
+
+Specialization& Specialization::Set(const uint32_t kId, const int32_t kValue)
+{
+	return Set(kId, static_cast<uint32_t>(kValue));
+}
+
+Specialization& Specialization::Set(const uint32_t kId, const float kValue)
+{
+	uint32_t bits;
+	memcpy(&bits, &kValue, sizeof(bits));
+	return Set(kId, bits);
+}
+
+uint64_t Specialization::Key() const
+{
+	if (_constants.empty())
+		return 0;
+
+	static_assert(sizeof(Constant) == 2 * sizeof(uint32_t), "Constant is padded, its bytes can't be hashed");
+	return ez::HashBytes(_constants.data(), _constants.size() * sizeof(Constant));
+}
+
+bool Specialization::operator==(const Specialization& kOther) const
+{
+	return _constants.size() == kOther._constants.size()
+		&& std::equal(_constants.begin(), _constants.end(), kOther._constants.begin(),
+						[](const Constant& kLhs, const Constant& kRhs) { return kLhs._id == kRhs._id && kLhs._value == kRhs._value; });
+}
+
 Material::Material(const Viewport& kViewport, const std::string kVertextShaderPath,
 						const std::string kFragmentShaderPath, const std::vector<BindingsSet>& kSets,
-						const VkCullModeFlagBits kCullMode, const int kVertexDataFlags,
-						const bool kWireframe)
-	: _setsLayout{ kSets.size() }
+						const VkCullModeFlagBits kCullMode, const bool kWireframe, const Vertex::Format kVertexFormat)
+	: _vertexFormat{ kVertexFormat }, _renderPass{ kViewport._renderPass }, _cullMode{ kCullMode }, _wireframe{ kWireframe }
 {
 	ASSERT(!kVertextShaderPath.empty(), "kVertextShaderPath is empty")
 	ASSERT(!kFragmentShaderPath.empty(), "kFragmentShaderPath is empty")
 
+	_vertexShader = &ShaderLibrary::Instance().Load(kVertextShaderPath);
+	_fragmentShader = &ShaderLibrary::Instance().Load(kFragmentShaderPath);
+
+	const std::array<const ShaderReflection*, 2> kReflections = { &_vertexShader->_reflection, &_fragmentShader->_reflection };
+	_reflection = ShaderReflection::Merge(kReflections);
+	ASSERT(_reflection._stage == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), "shaders are not a vertex and a fragment shader")
+
+	for (const ShaderReflection::Input& kInput : _reflection._inputs)
+	{
+		ASSERT(kInput._location <= GetLocation(Vertex::TANGENT), kVertextShaderPath + " reads a location no vertex attribute has")
+		_vertexDataFlags |= 1 << kInput._location;
+	}
+
 	CreateDescriptors(kSets);
-	CreatePipeline(kViewport, kVertextShaderPath, kFragmentShaderPath, kCullMode, kVertexDataFlags, kWireframe);
+	CreatePipelineLayout();
+
+	// The layouts are enough to create the instances, the pipeline is compiled by the workers meanwhile
+	_defaultVariant = &GetVariant({});
 }
 
 Material::~Material()
 {
+	Wait();
+
+	// The BINDLESS layout belongs to the registry
+	std::vector<VkDescriptorSetLayout> layouts;
 	for (size_t i = 0; i < _setsLayout.size(); ++i)
-		vkDestroyDescriptorSetLayout(LogicalDevice::Instance()._device, _setsLayout[i]._layout, Context::Instance()._allocator);
+	{
+		if (_setsLayout[i]._bindingsSet._scope != BindingsSet::Scope::BINDLESS)
+			layouts.push_back(_setsLayout[i]._layout);
+	}
+
+	std::vector<VkPipeline> pipelines;
+	for (const auto& kVariant : _variants)
+		pipelines.push_back(kVariant.second->_pipeline);
 
-	vkDestroyPipeline(LogicalDevice::Instance()._device, _pipeline, Context::Instance()._allocator);
-	vkDestroyPipelineLayout(LogicalDevice::Instance()._device, _pipelineLayout, Context::Instance()._allocator);
+	DeletionQueue::Push([layouts, pipelines, pipelineLayout = _pipelineLayout]() {
+		for (const VkDescriptorSetLayout kLayout : layouts)
+		{
+			DescriptorAllocator::Instance().UnregisterLayout(kLayout);
+			vkDestroyDescriptorSetLayout(LogicalDevice::Instance()._device, kLayout, Context::Instance()._allocator);
+		}
+
+		for (const VkPipeline kPipeline : pipelines)
+			vkDestroyPipeline(LogicalDevice::Instance()._device, kPipeline, Context::Instance()._allocator);
+		vkDestroyPipelineLayout(LogicalDevice::Instance()._device, pipelineLayout, Context::Instance()._allocator);
+	});
 }
 
 void Material::CreateDescriptors(const std::vector<BindingsSet>& kSets)
 {
+	_setsLayout.resize(std::max<size_t>(kSets.size(), _reflection.SetCount()));
+
+#ifndef NDEBUG
 	for (size_t i = 0; i < kSets.size(); ++i)
 	{
-		_setsLayout[i]._bindingsSet = kSets[i];
+		for (const Bindings& kBindings : kSets[i]._bindings)
+		{
+			ASSERT(_reflection.FindBinding(static_cast<uint32_t>(i), kBindings._binding) != nullptr,
+				"set " + std::to_string(i) + " binding " + std::to_string(kBindings._binding) + " is not in the shaders")
+		}
+	}
+#endif
+
+	for (const ShaderReflection::Binding& kReflected : _reflection._bindings)
+	{
+		// Laid out by the BindlessRegistry, the shaders are trusted to declare it the same way
+		if (kReflected._set < kSets.size() && kSets[kReflected._set]._scope == BindingsSet::Scope::BINDLESS)
+			continue;
+
+		ASSERT(kReflected._type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || kReflected._type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			"set " + std::to_string(kReflected._set) + " binding " + std::to_string(kReflected._binding) + " is neither a uniform buffer nor a sampler")
+		ASSERT(kReflected._count > 0, "runtime arrays can't be bound by materials")
+
+		Bindings bindings;
+		bindings._binding = static_cast<uint8_t>(kReflected._binding);
+		bindings._type = kReflected._type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ? Bindings::Type::BUFFER : Bindings::Type::SAMPLER;
+
+		// Only the dynamic buffers are declared, the shaders can't tell what is bound with an offset
+		if (kReflected._set < kSets.size())
+		{
+			for (const Bindings& kDeclared : kSets[kReflected._set]._bindings)
+			{
+				if (kDeclared._binding != kReflected._binding)
+					continue;
+
+				ASSERT(IsCompatible(kDeclared._type, kReflected._type),
+					"set " + std::to_string(kReflected._set) + " binding " + std::to_string(kReflected._binding) + " doesn't match the shaders")
+				bindings._type = kDeclared._type;
+				bindings._range = kDeclared._range;
+			}
+		}
+
+		if (bindings._type != Bindings::Type::SAMPLER && bindings._range == 0)
+			bindings._range = kReflected._size;
+		bindings._count = static_cast<uint8_t>(kReflected._count);
+		bindings._stages = kReflected._stages;
+
+		_setsLayout[kReflected._set]._bindingsSet._bindings.push_back(bindings);
+	}
 
-		std::vector<VkDescriptorSetLayoutBinding> layoutBinding{ kSets[i]._bindings.size() };
-		for (size_t j = 0; j < kSets[i]._bindings.size(); ++j)
+	for (size_t i = 0; i < _setsLayout.size(); ++i)
+	{
+		if (i < kSets.size())
+			_setsLayout[i]._bindingsSet._scope = kSets[i]._scope;
+
+		if (_setsLayout[i]._bindingsSet._scope == BindingsSet::Scope::BINDLESS)
+		{
+			ASSERT(BindlessRegistry::Instance().IsEnabled(), "set " + std::to_string(i) + " is bindless without descriptor indexing")
+			_setsLayout[i]._layout = BindlessRegistry::Instance()._layout;
+			continue;
+		}
+
+		const std::vector<Bindings>& kBindings = _setsLayout[i]._bindingsSet._bindings;
+
+		std::vector<VkDescriptorSetLayoutBinding> layoutBinding{ kBindings.size() };
+		for (size_t j = 0; j < kBindings.size(); ++j)
 		{
-			layoutBinding[j].descriptorType = kSets[i]._bindings[j]._type == Bindings::Type::BUFFER ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			layoutBinding[j].binding = kSets[i]._bindings[j]._binding;
-			layoutBinding[j].stageFlags = kSets[i]._bindings[j]._stage == Bindings::Stage::VERTEX ? VK_SHADER_STAGE_VERTEX_BIT : VK_SHADER_STAGE_FRAGMENT_BIT;
-			layoutBinding[j].descriptorCount = kSets[i]._bindings[j]._count;
+			layoutBinding[j].descriptorType = GetDescriptorType(kBindings[j]._type);
+			layoutBinding[j].binding = kBindings[j]._binding;
+			layoutBinding[j].stageFlags = kBindings[j]._stages;
+			layoutBinding[j].descriptorCount = kBindings[j]._count;
 		}
 
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
@@ -79,12 +356,12 @@ void Material::CreateDescriptors(const std::vector<BindingsSet>& kSets)
 
 		VkResult err = vkCreateDescriptorSetLayout(LogicalDevice::Instance()._device, &layoutInfo, Context::Instance()._allocator, &_setsLayout[i]._layout);
 		VK_ASSERT(err, "error when creating descriptor set layout");
+
+		DescriptorAllocator::Instance().RegisterLayout(_setsLayout[i]._layout, layoutBinding);
 	}
 }
 
-void Material::CreatePipeline(const Viewport& kViewport, const std::string kVertextShaderPath,
-								const std::string kFragmentShaderPath, const VkCullModeFlagBits kCullMode, const int kVertexDataFlags,
-								const bool kWireframe)
+void Material::CreatePipelineLayout()
 {
 	std::vector<VkDescriptorSetLayout> setLayouts{ _setsLayout.size() };
 	for (size_t i = 0; i < _setsLayout.size(); ++i)
@@ -94,23 +371,26 @@ void Material::CreatePipeline(const Viewport& kViewport, const std::string kVert
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = setLayouts.size(); // Optional
 	pipelineLayoutInfo.pSetLayouts = setLayouts.data(); // Optional
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+	pipelineLayoutInfo.pushConstantRangeCount = _reflection._pushConstant.size > 0 ? 1 : 0;
+	pipelineLayoutInfo.pPushConstantRanges = &_reflection._pushConstant;
 
 	VkResult err = vkCreatePipelineLayout(LogicalDevice::Instance()._device, &pipelineLayoutInfo, Context::Instance()._allocator, &_pipelineLayout);
 	VK_ASSERT(err, "error when creating pipeline layout");
+}
 
+void Material::CreatePipeline(const Specialization& kSpecialization, VkPipeline& pipeline) const
+{
 	// Rendering
 	VkPipelineInputAssemblyStateCreateInfo pipelineInputAssemblyStateCreateInfo{};
 	pipelineInputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	pipelineInputAssemblyStateCreateInfo.topology = kWireframe ? VK_PRIMITIVE_TOPOLOGY_LINE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	pipelineInputAssemblyStateCreateInfo.topology = _wireframe ? VK_PRIMITIVE_TOPOLOGY_LINE_STRIP : VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	pipelineInputAssemblyStateCreateInfo.flags = 0;
 	pipelineInputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
 
 	VkPipelineRasterizationStateCreateInfo pipelineRasterizationStateCreateInfo{};
 	pipelineRasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	pipelineRasterizationStateCreateInfo.polygonMode = kWireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
-	pipelineRasterizationStateCreateInfo.cullMode = kWireframe ? VK_CULL_MODE_NONE : kCullMode;
+	pipelineRasterizationStateCreateInfo.polygonMode = _wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+	pipelineRasterizationStateCreateInfo.cullMode = _wireframe ? VK_CULL_MODE_NONE : _cullMode;
 	pipelineRasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 	pipelineRasterizationStateCreateInfo.flags = 0;
 	pipelineRasterizationStateCreateInfo.depthClampEnable = VK_FALSE;
@@ -175,7 +455,7 @@ void Material::CreatePipeline(const Viewport& kViewport, const std::string kVert
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
 	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipelineCreateInfo.layout = _pipelineLayout;
-	pipelineCreateInfo.renderPass = kViewport._renderPass;
+	pipelineCreateInfo.renderPass = _renderPass;
 	pipelineCreateInfo.flags = 0;
 	pipelineCreateInfo.basePipelineIndex = -1;
 	pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
@@ -192,99 +472,258 @@ void Material::CreatePipeline(const Viewport& kViewport, const std::string kVert
 	pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
 	pipelineCreateInfo.pStages = shaderStages.data();
 
-	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
-	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-
-	/*err = vkCreatePipelineCache(kLogicalDevice._device, &pipelineCacheCreateInfo, _contextData._allocator, &_windowData._pipelineCache);
-	VK_ASSERT(err);*/
-
 	// TODO
-	auto flemme = Vertex::getBindingDescription(kVertexDataFlags);
-	auto flemme2 = Vertex::getAttributeDescriptions(kVertexDataFlags);
+	auto flemme = Vertex::getBindingDescriptions(_vertexDataFlags, _vertexFormat);
+	auto flemme2 = Vertex::getAttributeDescriptions(_vertexDataFlags, _vertexFormat);
 
 
 	VkPipelineVertexInputStateCreateInfo pipelineVertexInputStateCreateInfo{};
 	pipelineVertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-	pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = &flemme;
+	pipelineVertexInputStateCreateInfo.vertexBindingDescriptionCount = flemme.size();
+	pipelineVertexInputStateCreateInfo.pVertexBindingDescriptions = flemme.data();
 	pipelineVertexInputStateCreateInfo.vertexAttributeDescriptionCount = flemme2.size();
 	pipelineVertexInputStateCreateInfo.pVertexAttributeDescriptions = flemme2.data();
 
 	pipelineCreateInfo.pVertexInputState = &pipelineVertexInputStateCreateInfo;
 
-	VkShaderModule vertShaderModule = loadShader(kVertextShaderPath);
-	VkShaderModule fragShaderModule = loadShader(kFragmentShaderPath);
+	const std::array<const Shader*, 2> kShaders = { _vertexShader, _fragmentShader };
+	const std::array<VkShaderStageFlagBits, 2> kStages = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
 
-	shaderStages[0] = createShader(vertShaderModule, VK_SHADER_STAGE_VERTEX_BIT);
-	shaderStages[1] = createShader(fragShaderModule, VK_SHADER_STAGE_FRAGMENT_BIT);
-	err = vkCreateGraphicsPipelines(LogicalDevice::Instance()._device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, Context::Instance()._allocator, &_pipeline);
+	// Every constant is 32 bits, both stages get all of them and ignore the ids they don't declare
+	std::vector<VkSpecializationMapEntry> mapEntries(kSpecialization._constants.size());
+	std::vector<uint32_t> specializationData(kSpecialization._constants.size());
+	for (size_t i = 0; i < kSpecialization._constants.size(); ++i)
+	{
+		mapEntries[i] = { kSpecialization._constants[i]._id, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t) };
+		specializationData[i] = kSpecialization._constants[i]._value;
+	}
+
+	VkSpecializationInfo specializationInfo{};
+	specializationInfo.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+	specializationInfo.pMapEntries = mapEntries.data();
+	specializationInfo.dataSize = specializationData.size() * sizeof(uint32_t);
+	specializationInfo.pData = specializationData.data();
+
+	const VkSpecializationInfo* kSpecializationInfo = mapEntries.empty() ? nullptr : &specializationInfo;
+
+	VkResult err = VK_PIPELINE_COMPILE_REQUIRED;
+
+	// With identifiers the pipeline cache is tried first, the SPIR-V is only turned into modules when it misses
+	if (kShaders[0]->_identifier.identifierSize > 0 && kShaders[1]->_identifier.identifierSize > 0)
+	{
+		std::array<VkPipelineShaderStageModuleIdentifierCreateInfoEXT, 2> identifierInfos{};
+		for (size_t i = 0; i < shaderStages.size(); ++i)
+		{
+			identifierInfos[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_MODULE_IDENTIFIER_CREATE_INFO_EXT;
+			identifierInfos[i].identifierSize = kShaders[i]->_identifier.identifierSize;
+			identifierInfos[i].pIdentifier = kShaders[i]->_identifier.identifier;
+
+			shaderStages[i] = createShader(VK_NULL_HANDLE, kStages[i]);
+			shaderStages[i].pNext = &identifierInfos[i];
+			shaderStages[i].pSpecializationInfo = kSpecializationInfo;
+		}
+
+		pipelineCreateInfo.flags = VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT;
+		err = vkCreateGraphicsPipelines(LogicalDevice::Instance()._device, LogicalDevice::Instance()._pipelineCache, 1, &pipelineCreateInfo, Context::Instance()._allocator, &pipeline);
+		pipelineCreateInfo.flags = 0;
+	}
+
+	if (err == VK_PIPELINE_COMPILE_REQUIRED)
+	{
+		for (size_t i = 0; i < shaderStages.size(); ++i)
+		{
+			shaderStages[i] = createShader(ShaderLibrary::Instance().GetModule(*kShaders[i]), kStages[i]);
+			shaderStages[i].pSpecializationInfo = kSpecializationInfo;
+		}
+
+		err = vkCreateGraphicsPipelines(LogicalDevice::Instance()._device, LogicalDevice::Instance()._pipelineCache, 1, &pipelineCreateInfo, Context::Instance()._allocator, &pipeline);
+	}
 	VK_ASSERT(err, "error when creating graphics pipelines");
+}
+
+const Material::Variant& Material::GetVariant(const Specialization& kSpecialization) const
+{
+	std::lock_guard<std::mutex> lock(_variantsMutex);
+
+	std::unique_ptr<Variant>& variant = _variants[kSpecialization];
+	if (variant != nullptr)
+		return *variant;
+
+	variant = std::make_unique<Variant>();
+	variant->_specialization = kSpecialization;
 
-	vkDestroyShaderModule(LogicalDevice::Instance()._device, vertShaderModule, Context::Instance()._allocator);
-	vkDestroyShaderModule(LogicalDevice::Instance()._device, fragShaderModule, Context::Instance()._allocator);
+	Variant* const kVariant = variant.get();
+	variant->_build = ez::ThreadPool::Instance().Enqueue([this, kVariant]() {
+		CreatePipeline(kVariant->_specialization, kVariant->_pipeline);
+		kVariant->_ready.store(true, std::memory_order_release);
+	});
+
+	return *variant;
 }
 
-MaterialInstance::MaterialInstance(const Material& kMaterial, const std::vector<std::vector<void*>>& kData)
-	: _kMaterial{ &kMaterial }, _sets { _kMaterial->_setsLayout.size() }
+MaterialInstance::MaterialInstance(const Material& kMaterial, const std::vector<std::vector<void*>>& kData, const MaterialInstance* kFallback,
+									const Specialization& kSpecialization)
+	: _kMaterial{ &kMaterial }, _sets { _kMaterial->_setsLayout.size() }, _fallback{ kFallback }, _variant{ &kMaterial.GetVariant(kSpecialization) }
 {
 	for (size_t i = 0; i < _kMaterial->_setsLayout.size(); ++i)
 	{
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = LogicalDevice::Instance()._descriptorPool;
-		allocInfo.descriptorSetCount = 1;
-		allocInfo.pSetLayouts = &kMaterial._setsLayout[i]._layout;
-
-		VkResult err = vkAllocateDescriptorSets(LogicalDevice::Instance()._device, &allocInfo, &_sets[i]);
-		VK_ASSERT(err, "error when allocating descriptor sets");
+		if (_kMaterial->_setsLayout[i]._bindingsSet._scope == BindingsSet::Scope::BINDLESS)
+			_sets[i] = BindlessRegistry::Instance()._set;
+		else if (i < kData.size())
+			UpdateSet(i, kData[i]);
+		else
+			_sets[i] = DescriptorAllocator::Instance().Acquire(_kMaterial->_setsLayout[i]._layout, {});
 	}
-
-	for (size_t i = 0; i < kData.size(); ++i)
-		UpdateSet(i, kData[i]);
 }
 
 MaterialInstance::~MaterialInstance()
 {
+	// The transient sets go with their frame
 	for (size_t i = 0; i < _sets.size(); ++i)
 	{
-		VkResult err = vkFreeDescriptorSets(LogicalDevice::Instance()._device, LogicalDevice::Instance()._descriptorPool, 1, &_sets[i]);
-		VK_ASSERT(err, "error when freeing descriptor sets");
+		if (_kMaterial->_setsLayout[i]._bindingsSet._scope != BindingsSet::Scope::BINDLESS && (_transientSets & (1u << i)) == 0)
+			DescriptorAllocator::Instance().Release(_sets[i]);
 	}
+
+	BindlessRegistry::Instance().UnregisterMaterial(_materialIndex);
 }
 
-void MaterialInstance::Bind(const CommandBuffer& commandBuffer) const
+bool Material::Variant::IsReady() const
 {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _kMaterial->_pipeline);
+	return _ready.load(std::memory_order_acquire);
+}
 
-	for (size_t i = 0; i < _sets.size(); ++i)
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _kMaterial->_pipelineLayout, i, 1, &_sets[i], 0, nullptr);
+bool Material::IsReady() const
+{
+	return _defaultVariant->IsReady();
 }
 
-void MaterialInstance::UpdateSet(const uint8_t kSetIndex, const std::vector<void*>& kData) const
+void Material::Wait() const
 {
-	ASSERT(kSetIndex < _kMaterial->_setsLayout.size(), "index is out of size")
+	std::lock_guard<std::mutex> lock(_variantsMutex);
 
-	for (size_t j = 0; j < _kMaterial->_setsLayout[kSetIndex]._bindingsSet._bindings.size(); ++j)
+	// The builds never take the lock, waiting with it held keeps new variants out meanwhile
+	for (const auto& kVariant : _variants)
 	{
-		VkWriteDescriptorSet descriptorSet{};
-		descriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		descriptorSet.dstSet = _sets[kSetIndex];
-		descriptorSet.dstBinding = _kMaterial->_setsLayout[kSetIndex]._bindingsSet._bindings[j]._binding;
-		descriptorSet.descriptorCount = _kMaterial->_setsLayout[kSetIndex]._bindingsSet._bindings[j]._count;
+		if (kVariant.second->_build.valid())
+			kVariant.second->_build.wait();
+	}
+}
+
+const MaterialInstance* MaterialInstance::GetDrawable() const
+{
+	if (_variant->IsReady())
+		return this;
 
-		if (_kMaterial->_setsLayout[kSetIndex]._bindingsSet._bindings[j]._type == Bindings::Type::BUFFER)
+	return _fallback != nullptr ? _fallback->GetDrawable() : nullptr;
+}
+
+void MaterialInstance::Bind(CommandRecorder& recorder, const DynamicOffsets& kDynamicOffsets) const
+{
+	ASSERT(_variant->IsReady(), "material variant is still building, bind GetDrawable()")
+
+	recorder.BindPipeline(_variant->_pipeline);
+
+	// Offsets are consumed in set then binding order, they stay on the stack
+	std::array<uint32_t, CommandRecorder::MAX_DYNAMIC_OFFSETS> offsets;
+	std::array<uint32_t, CommandRecorder::MAX_SETS> offsetCounts{};
+	ASSERT(_sets.size() <= offsetCounts.size(), "more than " + std::to_string(offsetCounts.size()) + " sets")
+	size_t offsetCount = 0;
+	for (size_t i = 0; i < _kMaterial->_setsLayout.size(); ++i)
+	{
+		const BindingsSet& kBindingsSet = _kMaterial->_setsLayout[i]._bindingsSet;
+		for (const Bindings& kBindings : kBindingsSet._bindings)
 		{
-			descriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			VkDescriptorBufferInfo camBufferInfo = static_cast<Buffer*>(kData[j])->CreateDescriptorInfo();
-			descriptorSet.pBufferInfo = &camBufferInfo;
+			if (kBindings._type != Bindings::Type::DYNAMIC_BUFFER)
+				continue;
+
+			ASSERT(offsetCount + kBindings._count <= offsets.size(), "more than " + std::to_string(offsets.size()) + " dynamic offsets")
+			std::fill_n(offsets.begin() + offsetCount, kBindings._count, kDynamicOffsets[static_cast<size_t>(kBindingsSet._scope)]);
+			offsetCount += kBindings._count;
+			offsetCounts[i] += kBindings._count;
 		}
+	}
+
+	recorder.BindDescriptorSets(_kMaterial->_pipelineLayout, _sets, { offsets.data(), offsetCount }, { offsetCounts.data(), _sets.size() });
+}
+
+void MaterialInstance::Push(const CommandBuffer& commandBuffer, const DrawConstants& kConstants) const
+{
+	const VkPushConstantRange& kRange = _kMaterial->_reflection._pushConstant;
+	if (kRange.size == 0)
+		return;
+
+	ASSERT(kRange.offset + kRange.size <= sizeof(DrawConstants), "shaders push constants are bigger than DrawConstants")
+
+	vkCmdPushConstants(commandBuffer, _kMaterial->_pipelineLayout, kRange.stageFlags, kRange.offset, kRange.size,
+						reinterpret_cast<const uint8_t*>(&kConstants) + kRange.offset);
+}
+
+void MaterialInstance::UpdateSet(const uint8_t kSetIndex, const std::vector<void*>& kData)
+{
+	const std::vector<DescriptorInfo> kInfos = CreateInfos(kSetIndex, kData, {});
+
+	// Sets are never written once acquired, the instance moves to the set holding the new data
+	const VkDescriptorSet kPreviousSet = _sets[kSetIndex];
+	_sets[kSetIndex] = DescriptorAllocator::Instance().Acquire(_kMaterial->_setsLayout[kSetIndex]._layout, kInfos);
+	if (kPreviousSet != VK_NULL_HANDLE && (_transientSets & (1u << kSetIndex)) == 0)
+		DescriptorAllocator::Instance().Release(kPreviousSet);
+	_transientSets &= ~(1u << kSetIndex);
+}
+
+void MaterialInstance::UpdateTransientSet(const uint8_t kSetIndex, const std::vector<void*>& kData, const std::vector<uint32_t>& kOffsets)
+{
+	const std::vector<DescriptorInfo> kInfos = CreateInfos(kSetIndex, kData, kOffsets);
+
+	// Written once per frame, caching them would only fill the cache with sets used a single time
+	const VkDescriptorSet kPreviousSet = _sets[kSetIndex];
+	_sets[kSetIndex] = DescriptorAllocator::Instance().AllocateTransient(_kMaterial->_setsLayout[kSetIndex]._layout, kInfos);
+	if (kPreviousSet != VK_NULL_HANDLE && (_transientSets & (1u << kSetIndex)) == 0)
+		DescriptorAllocator::Instance().Release(kPreviousSet);
+	_transientSets |= 1u << kSetIndex;
+}
+
+std::vector<DescriptorInfo> MaterialInstance::CreateInfos(const uint8_t kSetIndex, const std::vector<void*>& kData, const std::vector<uint32_t>& kOffsets) const
+{
+	ASSERT(kSetIndex < _kMaterial->_setsLayout.size(), "index is out of size")
+	ASSERT(_kMaterial->_setsLayout[kSetIndex]._bindingsSet._scope != BindingsSet::Scope::BINDLESS, "the bindless set is written by the BindlessRegistry")
+
+	const std::vector<Bindings>& kSetBindings = _kMaterial->_setsLayout[kSetIndex]._bindingsSet._bindings;
+	ASSERT(kData.size() >= kSetBindings.size(), "set " + std::to_string(kSetIndex) + " is missing data")
+	ASSERT(kOffsets.size() <= kSetBindings.size(), "set " + std::to_string(kSetIndex) + " has more offsets than bindings")
+
+	// Packed in binding order, the whole set is written from it at once
+	std::vector<DescriptorInfo> infos;
+	for (size_t j = 0; j < kSetBindings.size(); ++j)
+	{
+		const Bindings& kBindings = kSetBindings[j];
+
+		DescriptorInfo info{};
+		if (kBindings._type == Bindings::Type::SAMPLER)
+			info._image = static_cast<Texture*>(kData[j])->CreateDescriptorInfo();
 		else
 		{
-			descriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			VkDescriptorImageInfo imageInfo = static_cast<Texture*>(kData[j])->CreateDescriptorInfo();
-			descriptorSet.pImageInfo = &imageInfo;
+			// Only the block the shaders read is shown, a dynamic buffer is then moved in the buffer by its offset
+			ASSERT(kBindings._range != 0u, "buffer binding has no _range")
+			info._buffer = static_cast<Buffer*>(kData[j])->CreateDescriptorInfo();
+			info._buffer.offset = j < kOffsets.size() ? kOffsets[j] : 0;
+			info._buffer.range = kBindings._range;
 		}
 
-		vkUpdateDescriptorSets(LogicalDevice::Instance()._device, 1, &descriptorSet, 0, nullptr);
+		// Every element of an array binding shows the same resource
+		infos.insert(infos.end(), kBindings._count, info);
 	}
+
+	return infos;
+}
+
+void MaterialInstance::SetBindlessTextures(const std::array<const Texture*, BindlessRegistry::MATERIAL_TEXTURES>& kTextures)
+{
+	BindlessRegistry::MaterialData data;
+	for (size_t i = 0; i < kTextures.size(); ++i)
+		data._textures[i] = kTextures[i] != nullptr ? kTextures[i]->_bindlessIndex : BindlessRegistry::INVALID_INDEX;
+
+	// The previous MaterialData stays valid for the frames in flight
+	BindlessRegistry::Instance().UnregisterMaterial(_materialIndex);
+	_materialIndex = BindlessRegistry::Instance().RegisterMaterial(data);
 }
\ No newline at end of file
@@ -0,0 +1,520 @@
+#include "VkRenderer/MemoryAllocator.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+#include "Core.h"
+#include "Utils.h"
+#include "VkRenderer/Context.h"
+#include "VkRenderer/Device.h"
+
+namespace
+{
+	uint32_t FindLastSet(const uint64_t kValue)
+	{
+#ifdef _MSC_VER
+		unsigned long index = 0;
+		_BitScanReverse64(&index, kValue);
+		return static_cast<uint32_t>(index);
+#else
+		return 63u - static_cast<uint32_t>(__builtin_clzll(kValue));
+#endif
+	}
+
+	uint32_t FindFirstSet(const uint64_t kValue)
+	{
+#ifdef _MSC_VER
+		unsigned long index = 0;
+		_BitScanForward64(&index, kValue);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(kValue));
+#endif
+	}
+}
+
+TlsfAllocator::TlsfAllocator(const VkDeviceSize kSize)
+	: _size{ kSize }
+{
+	ASSERT(kSize != 0u, "kSize is 0")
+
+	_freeLists.fill(INVALID_HANDLE);
+
+	const uint32_t kBlock = CreateBlock();
+	_blocks[kBlock]._size = kSize;
+	InsertFree(kBlock);
+}
+
+void TlsfAllocator::Mapping(const VkDeviceSize kSize, uint32_t& fl, uint32_t& sl)
+{
+	if (kSize < SL_COUNT)
+	{
+		fl = 0;
+		sl = static_cast<uint32_t>(kSize);
+		return;
+	}
+
+	const uint32_t kLastSet = FindLastSet(kSize);
+	fl = kLastSet - SL_COUNT_LOG2 + 1;
+	sl = static_cast<uint32_t>(kSize >> (kLastSet - SL_COUNT_LOG2)) ^ SL_COUNT;
+}
+
+uint32_t TlsfAllocator::CreateBlock()
+{
+	if (!_unusedBlocks.empty())
+	{
+		const uint32_t kBlock = _unusedBlocks.back();
+		_unusedBlocks.pop_back();
+		_blocks[kBlock] = Block{};
+		return kBlock;
+	}
+
+	_blocks.emplace_back();
+	return static_cast<uint32_t>(_blocks.size() - 1);
+}
+
+void TlsfAllocator::ReleaseBlock(const uint32_t kBlock)
+{
+	_unusedBlocks.push_back(kBlock);
+}
+
+void TlsfAllocator::InsertFree(const uint32_t kBlock)
+{
+	uint32_t fl = 0, sl = 0;
+	Mapping(_blocks[kBlock]._size, fl, sl);
+
+	uint32_t& head = _freeLists[fl * SL_COUNT + sl];
+
+	Block& block = _blocks[kBlock];
+	block._free = true;
+	block._prevFree = INVALID_HANDLE;
+	block._nextFree = head;
+	if (head != INVALID_HANDLE)
+		_blocks[head]._prevFree = kBlock;
+	head = kBlock;
+
+	_flBitmap |= 1ull << fl;
+	_slBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::RemoveFree(const uint32_t kBlock)
+{
+	uint32_t fl = 0, sl = 0;
+	Mapping(_blocks[kBlock]._size, fl, sl);
+
+	Block& block = _blocks[kBlock];
+	if (block._prevFree != INVALID_HANDLE)
+		_blocks[block._prevFree]._nextFree = block._nextFree;
+	else
+		_freeLists[fl * SL_COUNT + sl] = block._nextFree;
+
+	if (block._nextFree != INVALID_HANDLE)
+		_blocks[block._nextFree]._prevFree = block._prevFree;
+
+	block._free = false;
+	block._prevFree = INVALID_HANDLE;
+	block._nextFree = INVALID_HANDLE;
+
+	if (_freeLists[fl * SL_COUNT + sl] == INVALID_HANDLE)
+	{
+		_slBitmaps[fl] &= ~(1u << sl);
+		if (_slBitmaps[fl] == 0)
+			_flBitmap &= ~(1ull << fl);
+	}
+}
+
+uint32_t TlsfAllocator::FindFree(const VkDeviceSize kSize) const
+{
+	// Rounded up to the next size class, so any block of the list found is big enough
+	VkDeviceSize size = kSize;
+	if (size >= SL_COUNT)
+		size += (1ull << (FindLastSet(size) - SL_COUNT_LOG2)) - 1;
+
+	uint32_t fl = 0, sl = 0;
+	Mapping(size, fl, sl);
+	if (fl >= FL_COUNT)
+		return INVALID_HANDLE;
+
+	uint32_t slBitmap = _slBitmaps[fl] & (~0u << sl);
+	if (slBitmap == 0)
+	{
+		const uint64_t kFlBitmap = fl + 1 < 64 ? _flBitmap & (~0ull << (fl + 1)) : 0;
+		if (kFlBitmap == 0)
+			return INVALID_HANDLE;
+
+		fl = FindFirstSet(kFlBitmap);
+		slBitmap = _slBitmaps[fl];
+	}
+
+	sl = FindFirstSet(slBitmap);
+	return _freeLists[fl * SL_COUNT + sl];
+}
+
+uint32_t TlsfAllocator::Split(const uint32_t kBlock, const VkDeviceSize kSize)
+{
+	ASSERT(_blocks[kBlock]._size > kSize, "block is too small to be split")
+
+	const uint32_t kRest = CreateBlock();
+
+	Block& block = _blocks[kBlock];
+	Block& rest = _blocks[kRest];
+
+	rest._offset = block._offset + kSize;
+	rest._size = block._size - kSize;
+	rest._prevPhysical = kBlock;
+	rest._nextPhysical = block._nextPhysical;
+	if (rest._nextPhysical != INVALID_HANDLE)
+		_blocks[rest._nextPhysical]._prevPhysical = kRest;
+
+	block._size = kSize;
+	block._nextPhysical = kRest;
+
+	return kRest;
+}
+
+uint32_t TlsfAllocator::Allocate(const VkDeviceSize kSize, const VkDeviceSize kAlignment, VkDeviceSize& offset)
+{
+	ASSERT(kSize != 0u, "kSize is 0")
+	ASSERT(kAlignment != 0u && (kAlignment & (kAlignment - 1)) == 0, "kAlignment is not a power of 2")
+
+	// Worst case padding is searched for, so the block found always fits once aligned
+	uint32_t block = FindFree(kSize + kAlignment - 1);
+	if (block == INVALID_HANDLE)
+		return INVALID_HANDLE;
+
+	RemoveFree(block);
+
+	const VkDeviceSize kPadding = ez::AlignUp(_blocks[block]._offset, kAlignment) - _blocks[block]._offset;
+	if (kPadding != 0)
+	{
+		const uint32_t kPaddingBlock = block;
+		block = Split(kPaddingBlock, kPadding);
+		InsertFree(kPaddingBlock);
+	}
+
+	if (_blocks[block]._size > kSize)
+		InsertFree(Split(block, kSize));
+
+	_usedSize += _blocks[block]._size;
+	_allocationCount++;
+
+	offset = _blocks[block]._offset;
+	return block;
+}
+
+void TlsfAllocator::Free(const uint32_t kHandle)
+{
+	ASSERT(kHandle < _blocks.size() && !_blocks[kHandle]._free, "kHandle is not an allocation")
+
+	_usedSize -= _blocks[kHandle]._size;
+	_allocationCount--;
+
+	uint32_t block = kHandle;
+
+	// Merges with the free neighbours so the free blocks are never contiguous
+	const uint32_t kNext = _blocks[block]._nextPhysical;
+	if (kNext != INVALID_HANDLE && _blocks[kNext]._free)
+	{
+		RemoveFree(kNext);
+		_blocks[block]._size += _blocks[kNext]._size;
+		_blocks[block]._nextPhysical = _blocks[kNext]._nextPhysical;
+		if (_blocks[block]._nextPhysical != INVALID_HANDLE)
+			_blocks[_blocks[block]._nextPhysical]._prevPhysical = block;
+		ReleaseBlock(kNext);
+	}
+
+	const uint32_t kPrev = _blocks[block]._prevPhysical;
+	if (kPrev != INVALID_HANDLE && _blocks[kPrev]._free)
+	{
+		RemoveFree(kPrev);
+		_blocks[kPrev]._size += _blocks[block]._size;
+		_blocks[kPrev]._nextPhysical = _blocks[block]._nextPhysical;
+		if (_blocks[kPrev]._nextPhysical != INVALID_HANDLE)
+			_blocks[_blocks[kPrev]._nextPhysical]._prevPhysical = kPrev;
+		ReleaseBlock(block);
+		block = kPrev;
+	}
+
+	InsertFree(block);
+}
+
+bool TlsfAllocator::IsEmpty() const
+{
+	return _allocationCount == 0;
+}
+
+VkDeviceSize TlsfAllocator::Size() const
+{
+	return _size;
+}
+
+VkDeviceSize TlsfAllocator::UsedSize() const
+{
+	return _usedSize;
+}
+
+uint32_t TlsfAllocator::AllocationCount() const
+{
+	return _allocationCount;
+}
+
+MemoryAllocator* MemoryAllocator::_sInstance = nullptr;
+
+MemoryAllocator& MemoryAllocator::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+MemoryAllocator::MemoryAllocator()
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	_sInstance = this;
+
+	// Small heaps (BAR memory, integrated GPUs) get smaller blocks so one block doesn't take the whole heap
+	const VkPhysicalDeviceMemoryProperties& kProperties = LogicalDevice::Instance()._physicalDevice->_memoryProperties;
+	for (uint32_t i = 0; i < kProperties.memoryTypeCount; ++i)
+	{
+		const VkDeviceSize kHeapSize = kProperties.memoryHeaps[kProperties.memoryTypes[i].heapIndex].size;
+		_blockSizes[i] = std::min(BLOCK_SIZE, kHeapSize / 8);
+	}
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for (std::array<BlockList, static_cast<size_t>(ResourceType::COUNT)>& lists : _blocks)
+	{
+		for (BlockList& blocks : lists)
+		{
+			for (std::unique_ptr<MemoryBlock>& block : blocks)
+			{
+				ASSERT(block->_allocator.IsEmpty(), "memory block destroyed with live allocations")
+				vkFreeMemory(LogicalDevice::Instance()._device, block->_memory, Context::Instance()._allocator);
+			}
+		}
+	}
+
+	_sInstance = nullptr;
+}
+
+Allocation MemoryAllocator::AllocateDedicated(const VkDeviceSize kSize, const uint32_t kMemoryType)
+{
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = kSize;
+	allocInfo.memoryTypeIndex = kMemoryType;
+
+	Allocation allocation{};
+	VkResult result = vkAllocateMemory(LogicalDevice::Instance()._device, &allocInfo, Context::Instance()._allocator, &allocation._memory);
+	VK_ASSERT(result, "error when allocating memory");
+
+	allocation._size = kSize;
+	allocation._memoryType = kMemoryType;
+	MapAllocation(allocation, nullptr);
+
+	return allocation;
+}
+
+void MemoryAllocator::MapAllocation(Allocation& allocation, void* kMapped) const
+{
+	const VkMemoryPropertyFlags kFlags = LogicalDevice::Instance()._physicalDevice->_memoryProperties.memoryTypes[allocation._memoryType].propertyFlags;
+	if (!(kFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+		return;
+
+	allocation._coherent = (kFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+	if (kMapped == nullptr)
+	{
+		VkResult result = vkMapMemory(LogicalDevice::Instance()._device, allocation._memory, 0, VK_WHOLE_SIZE, 0, &kMapped);
+		VK_ASSERT(result, "error when mapping memory");
+	}
+
+	allocation._mapped = static_cast<uint8_t*>(kMapped) + allocation._offset;
+}
+
+VkMappedMemoryRange MemoryAllocator::GetMappedRange(const Allocation& kAllocation, const VkDeviceSize kOffset, const VkDeviceSize kSize) const
+{
+	ASSERT(kOffset + kSize <= kAllocation._size, "range is out of the allocation")
+
+	// Ranges have to be aligned on nonCoherentAtomSize, or reach the end of the memory
+	const VkDeviceSize kAtomSize = LogicalDevice::Instance()._physicalDevice->_properties.limits.nonCoherentAtomSize;
+	const VkDeviceSize kMemorySize = kAllocation._block != nullptr ? kAllocation._block->_allocator.Size() : kAllocation._size;
+
+	const VkDeviceSize kBegin = (kAllocation._offset + kOffset) / kAtomSize * kAtomSize;
+	const VkDeviceSize kEnd = ez::AlignUp(kAllocation._offset + kOffset + kSize, kAtomSize);
+
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = kAllocation._memory;
+	range.offset = kBegin;
+	range.size = kEnd >= kMemorySize ? VK_WHOLE_SIZE : kEnd - kBegin;
+
+	return range;
+}
+
+Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& kRequirements, const uint32_t kMemoryType, const ResourceType kType)
+{
+	ASSERT(kMemoryType < VK_MAX_MEMORY_TYPES, "kMemoryType is not a memory type")
+	ASSERT(kType != ResourceType::COUNT, "kType is not a resource type")
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	const VkDeviceSize kBlockSize = _blockSizes[kMemoryType];
+
+	// Big resources would waste most of a block, they get their own memory
+	if (kRequirements.size > kBlockSize / 2)
+	{
+		_dedicatedCounts[kMemoryType]++;
+		_dedicatedBytes[kMemoryType] += kRequirements.size;
+		return AllocateDedicated(kRequirements.size, kMemoryType);
+	}
+
+	BlockList& blocks = _blocks[kMemoryType][static_cast<size_t>(kType)];
+
+	Allocation allocation{};
+	allocation._size = kRequirements.size;
+	allocation._memoryType = kMemoryType;
+
+	for (std::unique_ptr<MemoryBlock>& block : blocks)
+	{
+		allocation._handle = block->_allocator.Allocate(kRequirements.size, kRequirements.alignment, allocation._offset);
+		if (allocation._handle != TlsfAllocator::INVALID_HANDLE)
+		{
+			allocation._block = block.get();
+			allocation._memory = block->_memory;
+			MapAllocation(allocation, block->_mapped);
+			return allocation;
+		}
+	}
+
+	std::unique_ptr<MemoryBlock> block = std::make_unique<MemoryBlock>(kBlockSize);
+	block->_memoryType = kMemoryType;
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = kBlockSize;
+	allocInfo.memoryTypeIndex = kMemoryType;
+
+	VkResult result = vkAllocateMemory(LogicalDevice::Instance()._device, &allocInfo, Context::Instance()._allocator, &block->_memory);
+	VK_ASSERT(result, "error when allocating memory block");
+
+	const VkMemoryPropertyFlags kFlags = LogicalDevice::Instance()._physicalDevice->_memoryProperties.memoryTypes[kMemoryType].propertyFlags;
+	if (kFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		result = vkMapMemory(LogicalDevice::Instance()._device, block->_memory, 0, VK_WHOLE_SIZE, 0, &block->_mapped);
+		VK_ASSERT(result, "error when mapping memory block");
+	}
+
+	allocation._handle = block->_allocator.Allocate(kRequirements.size, kRequirements.alignment, allocation._offset);
+	ASSERT(allocation._handle != TlsfAllocator::INVALID_HANDLE, "allocation doesn't fit in a new memory block")
+
+	allocation._block = block.get();
+	allocation._memory = block->_memory;
+	MapAllocation(allocation, block->_mapped);
+	blocks.push_back(std::move(block));
+
+	return allocation;
+}
+
+void MemoryAllocator::Free(Allocation& allocation)
+{
+	if (allocation._memory == VK_NULL_HANDLE)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (allocation._block == nullptr)
+	{
+		_dedicatedCounts[allocation._memoryType]--;
+		_dedicatedBytes[allocation._memoryType] -= allocation._size;
+		vkFreeMemory(LogicalDevice::Instance()._device, allocation._memory, Context::Instance()._allocator);
+		allocation = Allocation{};
+		return;
+	}
+
+	MemoryBlock* block = allocation._block;
+	block->_allocator.Free(allocation._handle);
+	allocation = Allocation{};
+
+	if (!block->_allocator.IsEmpty())
+		return;
+
+	// Empty blocks are released, but the last one of a list is kept to avoid reallocating it right away
+	for (BlockList& blocks : _blocks[block->_memoryType])
+	{
+		const auto kIt = std::find_if(blocks.begin(), blocks.end(), [block](const std::unique_ptr<MemoryBlock>& kBlock) { return kBlock.get() == block; });
+		if (kIt == blocks.end())
+			continue;
+
+		if (blocks.size() > 1)
+		{
+			vkFreeMemory(LogicalDevice::Instance()._device, block->_memory, Context::Instance()._allocator);
+			blocks.erase(kIt);
+		}
+		break;
+	}
+}
+
+void MemoryAllocator::Flush(const Allocation& kAllocation, const VkDeviceSize kOffset, const VkDeviceSize kSize) const
+{
+	if (kAllocation._coherent || kSize == 0)
+		return;
+
+	const VkMappedMemoryRange kRange = GetMappedRange(kAllocation, kOffset, kSize);
+	VkResult result = vkFlushMappedMemoryRanges(LogicalDevice::Instance()._device, 1, &kRange);
+	VK_ASSERT(result, "error when flushing mapped memory");
+}
+
+void MemoryAllocator::Invalidate(const Allocation& kAllocation, const VkDeviceSize kOffset, const VkDeviceSize kSize) const
+{
+	if (kAllocation._coherent || kSize == 0)
+		return;
+
+	const VkMappedMemoryRange kRange = GetMappedRange(kAllocation, kOffset, kSize);
+	VkResult result = vkInvalidateMappedMemoryRanges(LogicalDevice::Instance()._device, 1, &kRange);
+	VK_ASSERT(result, "error when invalidating mapped memory");
+}
+
+MemoryAllocator::Statistics MemoryAllocator::GetStatistics(const uint32_t kMemoryType) const
+{
+	ASSERT(kMemoryType < VK_MAX_MEMORY_TYPES, "kMemoryType is not a memory type")
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Statistics statistics{};
+	for (const BlockList& kBlocks : _blocks[kMemoryType])
+	{
+		for (const std::unique_ptr<MemoryBlock>& kBlock : kBlocks)
+		{
+			statistics._blockCount++;
+			statistics._allocationCount += kBlock->_allocator.AllocationCount();
+			statistics._blockBytes += kBlock->_allocator.Size();
+			statistics._usedBytes += kBlock->_allocator.UsedSize();
+		}
+	}
+
+	statistics._dedicatedCount = _dedicatedCounts[kMemoryType];
+	statistics._dedicatedBytes = _dedicatedBytes[kMemoryType];
+
+	return statistics;
+}
+
+MemoryAllocator::Statistics MemoryAllocator::GetStatistics() const
+{
+	Statistics total{};
+	for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+	{
+		const Statistics kStatistics = GetStatistics(i);
+		total._blockCount += kStatistics._blockCount;
+		total._allocationCount += kStatistics._allocationCount;
+		total._dedicatedCount += kStatistics._dedicatedCount;
+		total._blockBytes += kStatistics._blockBytes;
+		total._usedBytes += kStatistics._usedBytes;
+		total._dedicatedBytes += kStatistics._dedicatedBytes;
+	}
+
+	return total;
+}
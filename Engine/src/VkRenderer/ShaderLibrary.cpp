@@ -0,0 +1,121 @@
+#include "VkRenderer/ShaderLibrary.h"
+
+#include "Core.h"
+#include "Utils.h"
+#include "MappedFile.h"
+#include "VkRenderer/Context.h"
+#include "VkRenderer/Device.h"
+
+#include <cstring>
+
+ShaderLibrary* ShaderLibrary::_sInstance = nullptr;
+
+ShaderLibrary& ShaderLibrary::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+ShaderLibrary::ShaderLibrary()
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	_sInstance = this;
+
+	if (LogicalDevice::Instance()._shaderModuleIdentifier)
+	{
+		_getIdentifier = reinterpret_cast<PFN_vkGetShaderModuleCreateInfoIdentifierEXT>(
+							vkGetDeviceProcAddr(LogicalDevice::Instance()._device, "vkGetShaderModuleCreateInfoIdentifierEXT"));
+	}
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+	// Modules are only read when creating pipelines, they never reach the GPU timeline
+	for (const auto& kShader : _shaders)
+	{
+		if (kShader.second->_module != VK_NULL_HANDLE)
+			vkDestroyShaderModule(LogicalDevice::Instance()._device, kShader.second->_module, Context::Instance()._allocator);
+	}
+
+	_sInstance = nullptr;
+}
+
+VkShaderModuleCreateInfo ShaderLibrary::GetCreateInfo(const Shader& kShader)
+{
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = kShader._code.size() * sizeof(uint32_t);
+	createInfo.pCode = kShader._code.data();
+
+	return createInfo;
+}
+
+const Shader& ShaderLibrary::Load(const std::string& kPath)
+{
+	ASSERT(!kPath.empty(), "kPath is empty")
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		const auto kIt = _paths.find(kPath);
+		if (kIt != _paths.end())
+			return *kIt->second;
+	}
+
+	// Read and hashed without the lock, only the lookups are serialized
+	const ez::MappedFile kFile(kPath);
+	ASSERT(kFile.IsOpen(), "failed to open file " + kPath + " !")
+	ASSERT(kFile.Size() % sizeof(uint32_t) == 0, kPath + " is not SPIR-V, its size is not a multiple of 4")
+
+	const uint64_t kHash = ez::HashBytes(kFile.Data(), kFile.Size());
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::unique_ptr<Shader>& shader = _shaders[kHash];
+	if (shader == nullptr)
+	{
+		shader = std::make_unique<Shader>();
+		shader->_hash = kHash;
+		shader->_code.resize(kFile.Size() / sizeof(uint32_t));
+		memcpy(shader->_code.data(), kFile.Data(), kFile.Size());
+		shader->_reflection = ShaderReflection::Reflect(shader->_code);
+
+		if (_getIdentifier != nullptr)
+		{
+			const VkShaderModuleCreateInfo kCreateInfo = GetCreateInfo(*shader);
+
+			shader->_identifier.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_IDENTIFIER_EXT;
+			_getIdentifier(LogicalDevice::Instance()._device, &kCreateInfo, &shader->_identifier);
+		}
+	}
+	else
+	{
+		ASSERT(shader->_code.size() * sizeof(uint32_t) == kFile.Size() && memcmp(shader->_code.data(), kFile.Data(), kFile.Size()) == 0,
+			kPath + " hash collides with another shader")
+	}
+
+	_paths[kPath] = shader.get();
+	return *shader;
+}
+
+VkShaderModule ShaderLibrary::GetModule(const Shader& kShader)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Shader& shader = *_shaders.at(kShader._hash);
+	if (shader._module == VK_NULL_HANDLE)
+	{
+		const VkShaderModuleCreateInfo kCreateInfo = GetCreateInfo(shader);
+
+		VkResult err = vkCreateShaderModule(LogicalDevice::Instance()._device, &kCreateInfo, Context::Instance()._allocator, &shader._module);
+		VK_ASSERT(err, "error when creating shader module");
+	}
+
+	return shader._module;
+}
+
+size_t ShaderLibrary::ShaderCount() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _shaders.size();
+}
@@ -0,0 +1,462 @@
+#include "VkRenderer/ShaderReflection.h"
+
+#include "Core.h"
+
+#include <algorithm>
+#include <string>
+
+namespace
+{
+	constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+	constexpr size_t SPIRV_HEADER_SIZE = 5;
+
+	enum Op : uint16_t
+	{
+		OP_ENTRY_POINT			= 15,
+		OP_TYPE_INT				= 21,
+		OP_TYPE_FLOAT			= 22,
+		OP_TYPE_VECTOR			= 23,
+		OP_TYPE_MATRIX			= 24,
+		OP_TYPE_IMAGE			= 25,
+		OP_TYPE_SAMPLER			= 26,
+		OP_TYPE_SAMPLED_IMAGE	= 27,
+		OP_TYPE_ARRAY			= 28,
+		OP_TYPE_RUNTIME_ARRAY	= 29,
+		OP_TYPE_STRUCT			= 30,
+		OP_TYPE_POINTER			= 32,
+		OP_CONSTANT				= 43,
+		OP_FUNCTION				= 54,
+		OP_VARIABLE				= 59,
+		OP_DECORATE				= 71,
+		OP_MEMBER_DECORATE		= 72
+	};
+
+	enum Decoration : uint32_t
+	{
+		DECORATION_BUFFER_BLOCK		= 3,
+		DECORATION_ARRAY_STRIDE		= 6,
+		DECORATION_MATRIX_STRIDE	= 7,
+		DECORATION_BUILT_IN			= 11,
+		DECORATION_LOCATION			= 30,
+		DECORATION_BINDING			= 33,
+		DECORATION_DESCRIPTOR_SET	= 34,
+		DECORATION_OFFSET			= 35
+	};
+
+	enum StorageClass : uint32_t
+	{
+		STORAGE_CLASS_UNIFORM_CONSTANT	= 0,
+		STORAGE_CLASS_INPUT				= 1,
+		STORAGE_CLASS_UNIFORM			= 2,
+		STORAGE_CLASS_PUSH_CONSTANT		= 9,
+		STORAGE_CLASS_STORAGE_BUFFER	= 12
+	};
+
+	enum ImageDim : uint32_t
+	{
+		DIM_BUFFER			= 5,
+		DIM_SUBPASS_DATA	= 6
+	};
+
+	struct Member
+	{
+		uint32_t	_offset			= 0;
+		uint32_t	_matrixStride	= 0;
+	};
+
+	// What an id is defined and decorated with, the words point in the module
+	struct Id
+	{
+		const uint32_t*		_words			= nullptr;
+		uint16_t			_opcode			= 0;
+
+		uint32_t			_set			= 0;
+		uint32_t			_binding		= UINT32_MAX;
+		uint32_t			_location		= UINT32_MAX;
+		uint32_t			_arrayStride	= 0;
+		bool				_builtIn		= false;
+		bool				_bufferBlock	= false;
+		bool				_used			= false;
+
+		std::vector<Member>	_members;
+	};
+
+	Member& GetMember(Id& id, const uint32_t kIndex)
+	{
+		if (id._members.size() <= kIndex)
+			id._members.resize(kIndex + 1);
+		return id._members[kIndex];
+	}
+
+	uint32_t GetConstant(const std::vector<Id>& kIds, const uint32_t kId)
+	{
+		ASSERT(kIds[kId]._opcode == OP_CONSTANT, "array length is not a constant")
+		return kIds[kId]._words[3];
+	}
+
+	uint32_t GetSize(const std::vector<Id>& kIds, const uint32_t kType, const uint32_t kMatrixStride = 0)
+	{
+		const Id& kId = kIds[kType];
+		switch (kId._opcode)
+		{
+		case OP_TYPE_INT:
+		case OP_TYPE_FLOAT:
+			return kId._words[2] / 8;
+		case OP_TYPE_VECTOR:
+			return kId._words[3] * GetSize(kIds, kId._words[2]);
+		case OP_TYPE_MATRIX:
+			return kId._words[3] * (kMatrixStride != 0 ? kMatrixStride : GetSize(kIds, kId._words[2]));
+		case OP_TYPE_ARRAY:
+		{
+			const uint32_t kStride = kId._arrayStride != 0 ? kId._arrayStride : GetSize(kIds, kId._words[2], kMatrixStride);
+			return GetConstant(kIds, kId._words[3]) * kStride;
+		}
+		case OP_TYPE_STRUCT:
+		{
+			uint32_t size = 0;
+			for (uint32_t i = 0; i + 2 < kId._words[0] >> 16; ++i)
+			{
+				const Member kMember = i < kId._members.size() ? kId._members[i] : Member{};
+				size = std::max(size, kMember._offset + GetSize(kIds, kId._words[2 + i], kMember._matrixStride));
+			}
+			return size;
+		}
+		default:
+			// Runtime arrays have no size
+			return 0;
+		}
+	}
+
+	VkFormat GetFormat(const std::vector<Id>& kIds, const uint32_t kType)
+	{
+		const Id& kId = kIds[kType];
+
+		uint32_t components = 1;
+		const Id* kScalar = &kId;
+		if (kId._opcode == OP_TYPE_VECTOR)
+		{
+			components = kId._words[3];
+			kScalar = &kIds[kId._words[2]];
+		}
+
+		if (kScalar->_words[2] != 32)
+			return VK_FORMAT_UNDEFINED;
+
+		static constexpr VkFormat kFloatFormats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static constexpr VkFormat kIntFormats[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static constexpr VkFormat kUintFormats[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+		if (kScalar->_opcode == OP_TYPE_FLOAT)
+			return kFloatFormats[components - 1];
+		return kScalar->_words[3] != 0 ? kIntFormats[components - 1] : kUintFormats[components - 1];
+	}
+
+	// Matrices and arrays take a location per column or element
+	void AddInputs(const std::vector<Id>& kIds, const uint32_t kType, uint32_t& location, std::vector<ShaderReflection::Input>& inputs)
+	{
+		const Id& kId = kIds[kType];
+		if (kId._opcode == OP_TYPE_MATRIX)
+		{
+			for (uint32_t i = 0; i < kId._words[3]; ++i)
+				AddInputs(kIds, kId._words[2], location, inputs);
+		}
+		else if (kId._opcode == OP_TYPE_ARRAY)
+		{
+			for (uint32_t i = 0; i < GetConstant(kIds, kId._words[3]); ++i)
+				AddInputs(kIds, kId._words[2], location, inputs);
+		}
+		else
+			inputs.push_back({ location++, GetFormat(kIds, kType) });
+	}
+
+	VkShaderStageFlags GetStage(const uint32_t kExecutionModel)
+	{
+		switch (kExecutionModel)
+		{
+		case 0:
+			return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1:
+			return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2:
+			return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3:
+			return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4:
+			return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5:
+			return VK_SHADER_STAGE_COMPUTE_BIT;
+		default:
+			ASSERT(false, "unsupported execution model")
+			return 0;
+		}
+	}
+
+	VkDescriptorType GetDescriptorType(const std::vector<Id>& kIds, const uint32_t kStorageClass, const uint32_t kType)
+	{
+		const Id& kId = kIds[kType];
+
+		if (kStorageClass == STORAGE_CLASS_STORAGE_BUFFER || kId._bufferBlock)
+			return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		if (kStorageClass == STORAGE_CLASS_UNIFORM)
+			return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+		switch (kId._opcode)
+		{
+		case OP_TYPE_SAMPLER:
+			return VK_DESCRIPTOR_TYPE_SAMPLER;
+		case OP_TYPE_SAMPLED_IMAGE:
+			return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		case OP_TYPE_IMAGE:
+		{
+			const bool kStorage = kId._words[7] == 2;
+			if (kId._words[3] == DIM_BUFFER)
+				return kStorage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+			if (kId._words[3] == DIM_SUBPASS_DATA)
+				return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+			return kStorage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		}
+		default:
+			ASSERT(false, "unsupported descriptor type")
+			return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		}
+	}
+
+	bool BindingLess(const ShaderReflection::Binding& kLhs, const ShaderReflection::Binding& kRhs)
+	{
+		return kLhs._set != kRhs._set ? kLhs._set < kRhs._set : kLhs._binding < kRhs._binding;
+	}
+}
+
+ShaderReflection ShaderReflection::Reflect(ez::Span<const uint32_t> kCode)
+{
+	ASSERT(kCode.Size() >= SPIRV_HEADER_SIZE && kCode[0] == SPIRV_MAGIC, "code is not SPIR-V")
+
+	std::vector<Id> ids(kCode[3]);
+	std::vector<uint32_t> variables;
+
+	ShaderReflection reflection;
+
+	bool inFunctions = false;
+	for (size_t i = SPIRV_HEADER_SIZE; i < kCode.Size();)
+	{
+		const uint32_t* kWords = &kCode[i];
+		const uint16_t kWordCount = static_cast<uint16_t>(kWords[0] >> 16);
+		const uint16_t kOpcode = static_cast<uint16_t>(kWords[0] & 0xFFFF);
+		ASSERT(kWordCount > 0 && i + kWordCount <= kCode.Size(), "SPIR-V instruction is out of the code")
+
+		i += kWordCount;
+
+		// Any operand naming a variable counts as an access, literals colliding with one only widen the stages
+		if (kOpcode == OP_FUNCTION)
+			inFunctions = true;
+		if (inFunctions)
+		{
+			for (uint16_t j = 1; j < kWordCount; ++j)
+			{
+				if (kWords[j] < ids.size() && ids[kWords[j]]._opcode == OP_VARIABLE)
+					ids[kWords[j]]._used = true;
+			}
+			continue;
+		}
+
+		switch (kOpcode)
+		{
+		case OP_ENTRY_POINT:
+			if (reflection._stage == 0)
+				reflection._stage = GetStage(kWords[1]);
+			break;
+		case OP_DECORATE:
+		{
+			Id& id = ids[kWords[1]];
+			switch (kWords[2])
+			{
+			case DECORATION_BUFFER_BLOCK:
+				id._bufferBlock = true;
+				break;
+			case DECORATION_ARRAY_STRIDE:
+				id._arrayStride = kWords[3];
+				break;
+			case DECORATION_BUILT_IN:
+				id._builtIn = true;
+				break;
+			case DECORATION_LOCATION:
+				id._location = kWords[3];
+				break;
+			case DECORATION_BINDING:
+				id._binding = kWords[3];
+				break;
+			case DECORATION_DESCRIPTOR_SET:
+				id._set = kWords[3];
+				break;
+			}
+			break;
+		}
+		case OP_MEMBER_DECORATE:
+		{
+			Id& id = ids[kWords[1]];
+			if (kWords[3] == DECORATION_OFFSET)
+				GetMember(id, kWords[2])._offset = kWords[4];
+			else if (kWords[3] == DECORATION_MATRIX_STRIDE)
+				GetMember(id, kWords[2])._matrixStride = kWords[4];
+			else if (kWords[3] == DECORATION_BUILT_IN)
+				id._builtIn = true;
+			break;
+		}
+		case OP_CONSTANT:
+		case OP_VARIABLE:
+			ids[kWords[2]]._words = kWords;
+			ids[kWords[2]]._opcode = kOpcode;
+			if (kOpcode == OP_VARIABLE)
+				variables.push_back(kWords[2]);
+			break;
+		default:
+			if (kOpcode >= OP_TYPE_INT && kOpcode <= OP_TYPE_POINTER)
+			{
+				ids[kWords[1]]._words = kWords;
+				ids[kWords[1]]._opcode = kOpcode;
+			}
+			break;
+		}
+	}
+
+	ASSERT(reflection._stage != 0, "SPIR-V has no entry point")
+
+	for (const uint32_t kVariable : variables)
+	{
+		const Id& kId = ids[kVariable];
+		const uint32_t kStorageClass = kId._words[3];
+
+		const Id& kPointer = ids[kId._words[1]];
+		uint32_t type = kPointer._words[3];
+
+		switch (kStorageClass)
+		{
+		case STORAGE_CLASS_UNIFORM_CONSTANT:
+		case STORAGE_CLASS_UNIFORM:
+		case STORAGE_CLASS_STORAGE_BUFFER:
+		{
+			if (kId._binding == UINT32_MAX)
+				break;
+
+			Binding binding;
+			binding._set = kId._set;
+			binding._binding = kId._binding;
+			binding._stages = kId._used ? reflection._stage : 0;
+
+			while (ids[type]._opcode == OP_TYPE_ARRAY || ids[type]._opcode == OP_TYPE_RUNTIME_ARRAY)
+			{
+				binding._count = ids[type]._opcode == OP_TYPE_ARRAY ? binding._count * GetConstant(ids, ids[type]._words[3]) : 0;
+				type = ids[type]._words[2];
+			}
+
+			binding._type = GetDescriptorType(ids, kStorageClass, type);
+			if (ids[type]._opcode == OP_TYPE_STRUCT)
+				binding._size = GetSize(ids, type);
+
+			reflection._bindings.push_back(binding);
+			break;
+		}
+		case STORAGE_CLASS_PUSH_CONSTANT:
+		{
+			const Id& kBlock = ids[type];
+
+			uint32_t offset = UINT32_MAX;
+			for (const Member& kMember : kBlock._members)
+				offset = std::min(offset, kMember._offset);
+			if (offset == UINT32_MAX)
+				offset = 0;
+
+			reflection._pushConstant.stageFlags = reflection._stage;
+			reflection._pushConstant.offset = offset;
+			reflection._pushConstant.size = GetSize(ids, type) - offset;
+			break;
+		}
+		case STORAGE_CLASS_INPUT:
+		{
+			if (reflection._stage != VK_SHADER_STAGE_VERTEX_BIT || kId._builtIn || ids[type]._builtIn)
+				break;
+
+			ASSERT(kId._location != UINT32_MAX, "vertex input has no location")
+			uint32_t location = kId._location;
+			AddInputs(ids, type, location, reflection._inputs);
+			break;
+		}
+		}
+	}
+
+	std::sort(reflection._bindings.begin(), reflection._bindings.end(), BindingLess);
+	std::sort(reflection._inputs.begin(), reflection._inputs.end(), [](const Input& kLhs, const Input& kRhs) { return kLhs._location < kRhs._location; });
+
+	return reflection;
+}
+
+ShaderReflection ShaderReflection::Merge(ez::Span<const ShaderReflection* const> kStages)
+{
+	ShaderReflection merged;
+
+	// Stages declaring a binding, used when none of them accesses it
+	std::vector<VkShaderStageFlags> declared;
+
+	for (const ShaderReflection* kStage : kStages)
+	{
+		ASSERT((merged._stage & kStage->_stage) == 0, "stage is merged twice")
+		merged._stage |= kStage->_stage;
+
+		for (const Binding& kBinding : kStage->_bindings)
+		{
+			const auto kIt = std::lower_bound(merged._bindings.begin(), merged._bindings.end(), kBinding, BindingLess);
+			const size_t kIndex = kIt - merged._bindings.begin();
+
+			if (kIt == merged._bindings.end() || kIt->_set != kBinding._set || kIt->_binding != kBinding._binding)
+			{
+				merged._bindings.insert(kIt, kBinding);
+				declared.insert(declared.begin() + kIndex, kStage->_stage);
+				continue;
+			}
+
+			ASSERT(kIt->_type == kBinding._type && kIt->_count == kBinding._count,
+				"set " + std::to_string(kBinding._set) + " binding " + std::to_string(kBinding._binding) + " differs between stages")
+
+			kIt->_stages |= kBinding._stages;
+			kIt->_size = std::max(kIt->_size, kBinding._size);
+			declared[kIndex] |= kStage->_stage;
+		}
+
+		if (kStage->_pushConstant.size > 0)
+		{
+			VkPushConstantRange& range = merged._pushConstant;
+			const uint32_t kEnd = std::max(range.offset + range.size, kStage->_pushConstant.offset + kStage->_pushConstant.size);
+
+			range.offset = range.size > 0 ? std::min(range.offset, kStage->_pushConstant.offset) : kStage->_pushConstant.offset;
+			range.size = kEnd - range.offset;
+			range.stageFlags |= kStage->_stage;
+		}
+
+		if (kStage->_stage == VK_SHADER_STAGE_VERTEX_BIT)
+			merged._inputs = kStage->_inputs;
+	}
+
+	for (size_t i = 0; i < merged._bindings.size(); ++i)
+	{
+		if (merged._bindings[i]._stages == 0)
+			merged._bindings[i]._stages = declared[i];
+	}
+
+	return merged;
+}
+
+const ShaderReflection::Binding* ShaderReflection::FindBinding(const uint32_t kSet, const uint32_t kBinding) const
+{
+	for (const Binding& kReflected : _bindings)
+	{
+		if (kReflected._set == kSet && kReflected._binding == kBinding)
+			return &kReflected;
+	}
+
+	return nullptr;
+}
+
+uint32_t ShaderReflection::SetCount() const
+{
+	return _bindings.empty() ? 0 : _bindings.back()._set + 1;
+}
@@ -2,6 +2,8 @@
 
 #include "Core.h"
 #include "VkRenderer/Context.h"
+#include "VkRenderer/GpuTimeline.h"
+#include "VkRenderer/DeletionQueue.h"
 
 #include "GLFWWindowSystem.h"
 #include "ImGuiSystem.h"
@@ -9,17 +11,10 @@
 FrameData::FrameData()
 	: _commandBuffer{ LogicalDevice::Instance()._graphicsQueue }
 {
-	VkFenceCreateInfo fenceInfo = {};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	VkResult err = vkCreateFence(LogicalDevice::Instance()._device, &fenceInfo, Context::Instance()._allocator, &_fence);
-	VK_ASSERT(err, "error when creating fence");
-
 	VkSemaphoreCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	err = vkCreateSemaphore(LogicalDevice::Instance()._device, &info, Context::Instance()._allocator, &_presentComplete);
+	VkResult err = vkCreateSemaphore(LogicalDevice::Instance()._device, &info, Context::Instance()._allocator, &_presentComplete);
 	VK_ASSERT(err, "error when creating semaphore");
 
 	err = vkCreateSemaphore(LogicalDevice::Instance()._device, &info, Context::Instance()._allocator, &_renderComplete);
@@ -32,10 +27,9 @@ FrameData::~FrameData()
 }
 
 FrameData::FrameData(FrameData&& frameImage)
-	: _commandBuffer{ std::move(frameImage._commandBuffer) }, _fence{ frameImage._fence },
+	: _commandBuffer{ std::move(frameImage._commandBuffer) }, _submitValue{ frameImage._submitValue },
 	_presentComplete{ frameImage._presentComplete }, _renderComplete{ frameImage._renderComplete }
 {
-	frameImage._fence = VK_NULL_HANDLE;
 	frameImage._presentComplete = VK_NULL_HANDLE;
 	frameImage._renderComplete = VK_NULL_HANDLE;
 }
@@ -46,11 +40,10 @@ FrameData& FrameData::operator=(FrameData&& frameImage)
 
 	_commandBuffer = std::move(frameImage._commandBuffer);
 
-	_fence = frameImage._fence;
+	_submitValue = frameImage._submitValue;
 	_presentComplete = frameImage._presentComplete;
 	_renderComplete = frameImage._renderComplete;
 
-	frameImage._fence = VK_NULL_HANDLE;
 	frameImage._presentComplete = VK_NULL_HANDLE;
 	frameImage._renderComplete = VK_NULL_HANDLE;
 
@@ -59,12 +52,13 @@ FrameData& FrameData::operator=(FrameData&& frameImage)
 
 void FrameData::Clean()
 {
-	if (_presentComplete != VK_NULL_HANDLE)
-		vkDestroySemaphore(LogicalDevice::Instance()._device, _presentComplete, Context::Instance()._allocator);
-	if (_renderComplete != VK_NULL_HANDLE)
-		vkDestroySemaphore(LogicalDevice::Instance()._device, _renderComplete, Context::Instance()._allocator);
-	if (_fence != VK_NULL_HANDLE)
-		vkDestroyFence(LogicalDevice::Instance()._device, _fence, Context::Instance()._allocator);
+	if (_presentComplete == VK_NULL_HANDLE)
+		return;
+
+	DeletionQueue::Push([presentComplete = _presentComplete, renderComplete = _renderComplete]() {
+		vkDestroySemaphore(LogicalDevice::Instance()._device, presentComplete, Context::Instance()._allocator);
+		vkDestroySemaphore(LogicalDevice::Instance()._device, renderComplete, Context::Instance()._allocator);
+	});
 }
 
 FrameImage::FrameImage(const VkImage kImage, const VkFormat kFormat, const VkExtent2D& kExtent, const VkRenderPass kRenderPass)
@@ -115,8 +109,12 @@ FrameImage& FrameImage::operator=(FrameImage&& frameImage)
 
 void FrameImage::Clean()
 {
-	if (_framebuffer != VK_NULL_HANDLE)
-		vkDestroyFramebuffer(LogicalDevice::Instance()._device, _framebuffer, Context::Instance()._allocator);
+	if (_framebuffer == VK_NULL_HANDLE)
+		return;
+
+	DeletionQueue::Push([framebuffer = _framebuffer]() {
+		vkDestroyFramebuffer(LogicalDevice::Instance()._device, framebuffer, Context::Instance()._allocator);
+	});
 }
 
 Swapchain::Swapchain(const Surface& kSurface, const GLFWWindowData* windowData)
@@ -131,7 +129,7 @@ Swapchain::~Swapchain()
 	Clean();
 }
 
-void Swapchain::Init(const Surface& kSurface, const GLFWWindowData* windowData)
+void Swapchain::Init(const Surface& kSurface, const GLFWWindowData* windowData, const VkSwapchainKHR kOldSwapchain)
 {
 	VkSurfaceCapabilitiesKHR surfCaps;
 	VkResult err = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(LogicalDevice::Instance()._physicalDevice->_physicalDevice, kSurface._surface, &surfCaps);
@@ -222,7 +220,7 @@ void Swapchain::Init(const Surface& kSurface, const GLFWWindowData* windowData)
 	swapchainCI.queueFamilyIndexCount = 0;
 	swapchainCI.pQueueFamilyIndices = NULL;
 	swapchainCI.presentMode = swapchainPresentMode;
-	//swapchainCI.oldSwapchain = oldSwapchain;
+	swapchainCI.oldSwapchain = kOldSwapchain;
 	// Setting clipped to VK_TRUE allows the implementation to discard rendering outside of the surface area
 	swapchainCI.clipped = VK_FALSE;
 	swapchainCI.compositeAlpha = compositeAlpha;
@@ -288,37 +286,41 @@ void Swapchain::Init(const Surface& kSurface, const GLFWWindowData* windowData)
 	err = vkGetSwapchainImagesKHR(LogicalDevice::Instance()._device, _swapchain, &_imageCount, images.data());
 	VK_ASSERT(err, "error when gettings swapchain images KHR");
 
-	_framesData.reserve(_imageCount);
+	// Frames data outlive a resize, their last submissions may still be running
+	while (_framesData.size() < _imageCount)
+		_framesData.emplace_back();
+
 	_framesImage.reserve(_imageCount);
 	// Get the swap chain buffers containing the image and imageview
 	for (uint32_t i = 0; i < _imageCount; i++)
-	{
-		_framesData.emplace_back();
 		_framesImage.emplace_back(images[i], kSurface._colorFormat, _size, _renderPass);
-	}
 }
 
 void Swapchain::Clean()
 {
-	vkDeviceWaitIdle(LogicalDevice::Instance()._device);
-
 	_framesImage.clear();
 
-	vkDestroyRenderPass(LogicalDevice::Instance()._device, _renderPass, Context::Instance()._allocator);
-	vkDestroySwapchainKHR(LogicalDevice::Instance()._device, _swapchain, Context::Instance()._allocator);
+	DeletionQueue::Push([renderPass = _renderPass, swapchain = _swapchain]() {
+		vkDestroyRenderPass(LogicalDevice::Instance()._device, renderPass, Context::Instance()._allocator);
+		vkDestroySwapchainKHR(LogicalDevice::Instance()._device, swapchain, Context::Instance()._allocator);
+	});
 }
 
 void Swapchain::Resize(const Surface& kSurface, const GLFWWindowData* windowData)
 {
 	ASSERT(windowData != nullptr, "windowData is nullptr")
 
+	// The old swapchain is retired by the new one, and destroyed once its frames are done
+	const VkSwapchainKHR kOldSwapchain = _swapchain;
+
 	Clean();
-	Init(kSurface, windowData);
+	Init(kSurface, windowData, kOldSwapchain);
 }
 
 bool Swapchain::AcquireNextImage()
 {
-	vkWaitForFences(LogicalDevice::Instance()._device, 1, &_framesData[_currentFrame]._fence, VK_TRUE, UINT64_MAX);
+	// The command buffer and semaphores of the frame are reused, its last submission has to be done
+	GpuTimeline::Instance().Wait(LogicalDevice::Instance()._graphicsQueue, _framesData[_currentFrame]._submitValue);
 
 	VkResult err = vkAcquireNextImageKHR(LogicalDevice::Instance()._device, _swapchain, UINT64_MAX,
 											_framesData[_currentFrame]._presentComplete, VK_NULL_HANDLE, &_currentImage);
@@ -401,10 +403,7 @@ void Swapchain::Render()
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
-	vkResetFences(LogicalDevice::Instance()._device, 1, &_framesData[_currentFrame]._fence);
-	VkResult err = vkQueueSubmit(LogicalDevice::Instance()._graphicsQueue._queue, 1, &submitInfo,
-		_framesData[_currentFrame]._fence);
-	VK_ASSERT(err, "error when submitting queue");
+	_framesData[_currentFrame]._submitValue = GpuTimeline::Instance().Submit(LogicalDevice::Instance()._graphicsQueue, submitInfo);
 }
 
 bool Swapchain::Present()
@@ -418,7 +417,7 @@ bool Swapchain::Present()
 	VkSwapchainKHR swapChains[] = { _swapchain };
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = swapChains;
-	presentInfo.pImageIndices = &_currentFrame;
+	presentInfo.pImageIndices = &_currentImage;
 
 	presentInfo.pResults = nullptr; // Optional
 
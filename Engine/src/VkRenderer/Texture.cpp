@@ -3,7 +3,8 @@
 #include "Core.h"
 #include "VkRenderer/Context.h"
 
-#include "VkRenderer/Buffer.h"
+#include "VkRenderer/UploadBatcher.h"
+#include "VkRenderer/DeletionQueue.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -18,20 +19,17 @@ Texture::Texture(const std::string kTexturePath, const Format kFormat)
 
 	ASSERT(pixels, "failed to load texture image " + kTexturePath + " !")
 
-	Buffer stagingBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-	stagingBuffer.Map(pixels, static_cast<size_t>(imageSize));
-	
-	stbi_image_free(pixels);
-
 	ImageBuffer image(GetVkFormat(kFormat), { static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight) },
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 	_image = std::move(image);
 
-	_image.TransitionLayout(LogicalDevice::Instance()._transferQueue, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	_image.CopyBuffer(LogicalDevice::Instance()._transferQueue, stagingBuffer);
-	_image.TransitionLayout(LogicalDevice::Instance()._graphicsQueue, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	const void* kLayers[] = { pixels };
+	_uploadTicket = UploadBatcher::Instance().Upload(_image, kLayers, static_cast<size_t>(imageSize));
+
+	stbi_image_free(pixels);
 
 	CreateSampler();
+	_bindlessIndex = BindlessRegistry::Instance().RegisterTexture(*this);
 }
 
 Texture::Texture(const std::array<std::string, 6> kCubemapPath, const Format kFormat)
@@ -56,28 +54,28 @@ Texture::Texture(const std::array<std::string, 6> kCubemapPath, const Format kFo
 		cubeHeight = texHeight;
 	}
 
-	Buffer stagingBuffer(cubemapSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-	for (int i = 0; i < 6; ++i)
-	{
-		stagingBuffer.Map(pixels[i], static_cast<size_t>(cubemapSize / 6), static_cast<size_t>((cubemapSize / 6) * i));
-		stbi_image_free(pixels[i]);
-	}
-
 	ImageBuffer image(GetVkFormat(kFormat), { static_cast<uint32_t>(cubeWidth), static_cast<uint32_t>(cubeHeight) },
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, true);
 	_image = std::move(image);
 
-	_image.TransitionLayout(LogicalDevice::Instance()._transferQueue, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	_image.CopyBuffer(LogicalDevice::Instance()._transferQueue, stagingBuffer);
-	_image.TransitionLayout(LogicalDevice::Instance()._graphicsQueue, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	const void* kLayers[] = { pixels[0], pixels[1], pixels[2], pixels[3], pixels[4], pixels[5] };
+	_uploadTicket = UploadBatcher::Instance().Upload(_image, kLayers, static_cast<size_t>(cubemapSize / 6));
+
+	for (int i = 0; i < 6; ++i)
+		stbi_image_free(pixels[i]);
 
 	CreateSampler();
+	_bindlessIndex = BindlessRegistry::Instance().RegisterTexture(*this);
 }
 
 
 Texture::~Texture()
 {
-	vkDestroySampler(LogicalDevice::Instance()._device, _sampler, Context::Instance()._allocator);
+	BindlessRegistry::Instance().UnregisterTexture(*this, _bindlessIndex);
+
+	DeletionQueue::Push([sampler = _sampler]() {
+		vkDestroySampler(LogicalDevice::Instance()._device, sampler, Context::Instance()._allocator);
+	});
 }
 
 void Texture::CreateSampler()
@@ -115,6 +113,11 @@ uint8_t Texture::GetNumberChannels(const Format kFormat) const
 	return (static_cast<int>(kFormat) % 4) + 1; 
 };
 
+bool Texture::IsUploaded() const
+{
+	return UploadBatcher::Instance().IsComplete(_uploadTicket);
+}
+
 VkFormat Texture::GetVkFormat(const Format kFormat) const
 {
 	VkFormat imageFormat = kFormat == Format::SRGBA ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
@@ -0,0 +1,62 @@
+#include "VkRenderer/UniformRing.h"
+
+#include "Core.h"
+#include "Utils.h"
+
+namespace
+{
+	VkDeviceSize GetUniformAlignment()
+	{
+		return LogicalDevice::Instance()._physicalDevice->_properties.limits.minUniformBufferOffsetAlignment;
+	}
+}
+
+UniformRing* UniformRing::_sInstance = nullptr;
+
+UniformRing& UniformRing::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+UniformRing::UniformRing(const VkDeviceSize kFrameSize)
+	: _buffer{ ez::AlignUp(kFrameSize, GetUniformAlignment()) * FRAME_COUNT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, Buffer::MemoryUsage::UPLOAD },
+	_frameSize{ ez::AlignUp(kFrameSize, GetUniformAlignment()) }, _alignment{ GetUniformAlignment() }
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	ASSERT(kFrameSize != 0u, "kFrameSize is 0")
+
+	_sInstance = this;
+}
+
+UniformRing::~UniformRing()
+{
+	_sInstance = nullptr;
+}
+
+void UniformRing::BeginFrame()
+{
+	// Everything reading the region of the frame is submitted by now
+	_points[_frame] = GpuTimeline::Instance().GetSubmittedPoint();
+	_frame = (_frame + 1) % FRAME_COUNT;
+
+	GpuTimeline::Instance().Wait(_points[_frame]);
+	_head = 0;
+}
+
+void UniformRing::EndFrame() const
+{
+	_buffer.Flush();
+}
+
+uint32_t UniformRing::Write(const void* kData, const size_t kSize)
+{
+	ASSERT(kSize != 0u, "kSize is 0")
+	ASSERT(_head + kSize <= _frameSize, "uniform ring is full, " + std::to_string(_frameSize) + " bytes per frame")
+
+	const VkDeviceSize kOffset = _frame * _frameSize + _head;
+	_buffer.Write(kData, kSize, kOffset);
+
+	_head = ez::AlignUp(_head + kSize, _alignment);
+	return static_cast<uint32_t>(kOffset);
+}
@@ -0,0 +1,275 @@
+#include "VkRenderer/UploadBatcher.h"
+
+#include "Core.h"
+#include "VkRenderer/GpuTimeline.h"
+
+namespace
+{
+	// Every way a resource uploaded for the graphics queue can be read
+	constexpr VkPipelineStageFlags READ_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+													| VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	constexpr VkAccessFlags READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+											| VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+}
+
+UploadBatcher::Batch::Batch()
+	: _transferCommands{ LogicalDevice::Instance()._transferQueue }, _graphicsCommands{ LogicalDevice::Instance()._graphicsQueue }
+{
+}
+
+UploadBatcher* UploadBatcher::_sInstance = nullptr;
+
+UploadBatcher& UploadBatcher::Instance()
+{
+	ASSERT(_sInstance != nullptr, "_sInstance is nullptr")
+	return *_sInstance;
+}
+
+UploadBatcher::UploadBatcher()
+{
+	ASSERT(_sInstance == nullptr, "_sInstance is already set")
+	_sInstance = this;
+}
+
+UploadBatcher::~UploadBatcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		SubmitRecording();
+	}
+
+	for (const std::unique_ptr<Batch>& kBatch : _batches)
+	{
+		if (kBatch->_state == State::SUBMITTED)
+			GpuTimeline::Instance().Wait(GetLastQueue(), kBatch->_submitValue);
+	}
+
+	_sInstance = nullptr;
+}
+
+bool UploadBatcher::IsSameFamily()
+{
+	return LogicalDevice::Instance()._transferQueue._indice == LogicalDevice::Instance()._graphicsQueue._indice;
+}
+
+const Queue& UploadBatcher::GetLastQueue()
+{
+	return IsSameFamily() ? LogicalDevice::Instance()._transferQueue : LogicalDevice::Instance()._graphicsQueue;
+}
+
+UploadBatcher::Batch& UploadBatcher::GetRecordingBatch()
+{
+	if (_recording != nullptr)
+		return *_recording;
+
+	for (const std::unique_ptr<Batch>& kBatch : _batches)
+	{
+		if (kBatch->_state == State::FREE)
+		{
+			_recording = kBatch.get();
+			break;
+		}
+	}
+
+	if (_recording == nullptr)
+	{
+		_batches.push_back(std::make_unique<Batch>());
+		_recording = _batches.back().get();
+	}
+
+	_recording->_transferCommands.Begin();
+	if (!IsSameFamily())
+		_recording->_graphicsCommands.Begin();
+
+	_recording->_ticket = _nextTicket++;
+	_recording->_state = State::RECORDING;
+
+	return *_recording;
+}
+
+Buffer& UploadBatcher::CreateStagingBuffer(Batch& batch, const size_t kSize)
+{
+	batch._stagingBuffers.emplace_back(kSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, Buffer::MemoryUsage::UPLOAD);
+	return batch._stagingBuffers.back();
+}
+
+UploadBatcher::Ticket UploadBatcher::Upload(const Buffer& kBuffer, const void* kData, const size_t kSize, const size_t kOffset)
+{
+	ASSERT(kBuffer._memoryUsage == Buffer::MemoryUsage::DEVICE_LOCAL, "kBuffer is not device local, write it directly")
+	ASSERT(kOffset + kSize <= kBuffer._size, "(kOffset + kSize) > kBuffer._size, uploading to unknown memory")
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Batch& batch = GetRecordingBatch();
+
+	const Buffer& kStagingBuffer = CreateStagingBuffer(batch, kSize);
+	kStagingBuffer.Write(kData, kSize);
+	kStagingBuffer.Flush();
+
+	kBuffer.CopyBuffer(batch._transferCommands, kStagingBuffer, kSize, 0, kOffset);
+
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = READ_ACCESS;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = kBuffer;
+	barrier.offset = kOffset;
+	barrier.size = kSize;
+
+	if (IsSameFamily())
+	{
+		vkCmdPipelineBarrier(batch._transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, READ_STAGES, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+		return batch._ticket;
+	}
+
+	// Release on the transfer queue, then the same barrier acquires on the graphics queue
+	barrier.srcQueueFamilyIndex = LogicalDevice::Instance()._transferQueue._indice;
+	barrier.dstQueueFamilyIndex = LogicalDevice::Instance()._graphicsQueue._indice;
+
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(batch._transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = READ_ACCESS;
+	vkCmdPipelineBarrier(batch._graphicsCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, READ_STAGES, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	return batch._ticket;
+}
+
+UploadBatcher::Ticket UploadBatcher::Upload(const ImageBuffer& kImage, ez::Span<const void* const> kLayers, const size_t kLayerSize)
+{
+	ASSERT(kLayers.Size() == kImage.GetSubresourceRange().layerCount, "kLayers doesn't match the layers of kImage")
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Batch& batch = GetRecordingBatch();
+
+	// Layers are packed one after the other, the layout the copy expects
+	const Buffer& kStagingBuffer = CreateStagingBuffer(batch, kLayerSize * kLayers.Size());
+	for (size_t i = 0; i < kLayers.Size(); ++i)
+		kStagingBuffer.Write(kLayers[i], kLayerSize, kLayerSize * i);
+	kStagingBuffer.Flush();
+
+	kImage.TransitionLayout(batch._transferCommands, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	kImage.CopyBuffer(batch._transferCommands, kStagingBuffer);
+
+	if (IsSameFamily())
+	{
+		kImage.TransitionLayout(batch._transferCommands, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		return batch._ticket;
+	}
+
+	// The layout transition is part of the ownership transfer, both barriers have to describe it
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcQueueFamilyIndex = LogicalDevice::Instance()._transferQueue._indice;
+	barrier.dstQueueFamilyIndex = LogicalDevice::Instance()._graphicsQueue._indice;
+	barrier.image = kImage._image;
+	barrier.subresourceRange = kImage.GetSubresourceRange();
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	vkCmdPipelineBarrier(batch._transferCommands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(batch._graphicsCommands, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, READ_STAGES, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	return batch._ticket;
+}
+
+void UploadBatcher::SubmitRecording()
+{
+	if (_recording == nullptr)
+		return;
+
+	Batch& batch = *_recording;
+	_recording = nullptr;
+
+	batch._transferCommands.End();
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &batch._transferCommands._commandBuffer;
+
+	batch._submitValue = GpuTimeline::Instance().Submit(LogicalDevice::Instance()._transferQueue, submitInfo);
+
+	if (!IsSameFamily())
+	{
+		batch._graphicsCommands.End();
+
+		// The acquire waits on the transfer timeline, no semaphore has to be kept per batch
+		const GpuTimeline::WaitInfo kWait{ &LogicalDevice::Instance()._transferQueue, batch._submitValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+
+		VkSubmitInfo acquireInfo{};
+		acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		acquireInfo.commandBufferCount = 1;
+		acquireInfo.pCommandBuffers = &batch._graphicsCommands._commandBuffer;
+
+		batch._submitValue = GpuTimeline::Instance().Submit(LogicalDevice::Instance()._graphicsQueue, acquireInfo, { &kWait, 1 });
+	}
+
+	batch._state = State::SUBMITTED;
+}
+
+void UploadBatcher::Poll()
+{
+	for (const std::unique_ptr<Batch>& kBatch : _batches)
+	{
+		if (kBatch->_state != State::SUBMITTED || !GpuTimeline::Instance().IsComplete(GetLastQueue(), kBatch->_submitValue))
+			continue;
+
+		kBatch->_stagingBuffers.clear();
+		kBatch->_state = State::FREE;
+	}
+}
+
+void UploadBatcher::Submit()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	SubmitRecording();
+}
+
+void UploadBatcher::Update()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	SubmitRecording();
+	Poll();
+}
+
+bool UploadBatcher::IsComplete(const Ticket kTicket)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	Poll();
+
+	for (const std::unique_ptr<Batch>& kBatch : _batches)
+	{
+		if (kBatch->_state != State::FREE && kBatch->_ticket == kTicket)
+			return false;
+	}
+
+	return true;
+}
+
+void UploadBatcher::Wait(const Ticket kTicket)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_recording != nullptr && _recording->_ticket == kTicket)
+		SubmitRecording();
+
+	for (const std::unique_ptr<Batch>& kBatch : _batches)
+	{
+		if (kBatch->_state != State::SUBMITTED || kBatch->_ticket != kTicket)
+			continue;
+
+		GpuTimeline::Instance().Wait(GetLastQueue(), kBatch->_submitValue);
+	}
+
+	Poll();
+}
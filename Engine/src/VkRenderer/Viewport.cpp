@@ -6,6 +6,8 @@
 
 #include "Core.h"
 #include "VkRenderer/Context.h"
+#include "VkRenderer/GpuTimeline.h"
+#include "VkRenderer/DeletionQueue.h"
 
 Viewport::Viewport(const VkFormat kFormat, const VkExtent2D kExtent)
 	: _commandBuffer{ LogicalDevice::Instance()._graphicsQueue }, _size { kExtent }
@@ -13,19 +15,10 @@ Viewport::Viewport(const VkFormat kFormat, const VkExtent2D kExtent)
 	ASSERT(kExtent.width != 0 && kExtent.height != 0, "kExtent.width is 0 or kExtent.height is 0")
 
 	Init(kFormat);
-
-	VkFenceCreateInfo info = {};
-	info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	VkResult err = vkCreateFence(LogicalDevice::Instance()._device, &info, Context::Instance()._allocator, &_fence);
-	VK_ASSERT(err, "error when creating fence");
 }
 
 Viewport::~Viewport()
 {
-	vkDestroyFence(LogicalDevice::Instance()._device, _fence, Context::Instance()._allocator);
-
 	Clean();
 }
 
@@ -143,15 +136,16 @@ void Viewport::Init(const VkFormat kFormat)
 
 void Viewport::Clean()
 {
-	vkDeviceWaitIdle(LogicalDevice::Instance()._device);
-
-	VkResult err = vkFreeDescriptorSets(LogicalDevice::Instance()._device, LogicalDevice::Instance()._descriptorPool, 1, &_set);
-	VK_ASSERT(err, "error when freeing descriptor sets");
+	// The last frames may still sample the viewport, the images follow the same path when they are replaced
+	DeletionQueue::Push([set = _set, sampler = _sampler, framebuffer = _framebuffer, renderPass = _renderPass]() {
+		VkResult err = vkFreeDescriptorSets(LogicalDevice::Instance()._device, LogicalDevice::Instance()._descriptorPool, 1, &set);
+		VK_ASSERT(err, "error when freeing descriptor sets");
 
-	vkDestroySampler(LogicalDevice::Instance()._device, _sampler, Context::Instance()._allocator);
-	vkDestroyFramebuffer(LogicalDevice::Instance()._device, _framebuffer, Context::Instance()._allocator);
+		vkDestroySampler(LogicalDevice::Instance()._device, sampler, Context::Instance()._allocator);
+		vkDestroyFramebuffer(LogicalDevice::Instance()._device, framebuffer, Context::Instance()._allocator);
 
-	vkDestroyRenderPass(LogicalDevice::Instance()._device, _renderPass, Context::Instance()._allocator);
+		vkDestroyRenderPass(LogicalDevice::Instance()._device, renderPass, Context::Instance()._allocator);
+	});
 }
 
 void Viewport::Resize(const VkFormat kFormat)
@@ -197,8 +191,8 @@ bool Viewport::UpdateViewportSize()
 
 void Viewport::StartDraw()
 {
-	VkResult err = vkWaitForFences(LogicalDevice::Instance()._device, 1, &_fence, VK_TRUE, UINT64_MAX);
-	VK_ASSERT(err, "error when waiting for fences");
+	// The command buffer is reused, its last submission has to be done
+	GpuTimeline::Instance().Wait(LogicalDevice::Instance()._graphicsQueue, _submitValue);
 
 	/**********************************************************************************************/
 
@@ -255,8 +249,5 @@ void Viewport::Render()
 
 	submitInfo.signalSemaphoreCount = 0;
 
-	VkResult err = vkResetFences(LogicalDevice::Instance()._device, 1, &_fence);
-	VK_ASSERT(err, "error when reseting fences");
-	err = vkQueueSubmit(LogicalDevice::Instance()._graphicsQueue._queue, 1, &submitInfo, _fence);
-	VK_ASSERT(err, "error when submitting queue");
+	_submitValue = GpuTimeline::Instance().Submit(LogicalDevice::Instance()._graphicsQueue, submitInfo);
 }
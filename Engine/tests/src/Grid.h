@@ -0,0 +1,46 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "VkRenderer/Material.h"
+
+// Grid of kSize x kSize quads facing +y, bent by kHeight on y.
+// Shuffled triangles are a worst case for the vertex cache, the same seed always gives the same order
+inline void CreateGrid(const uint32_t kSize, const float kHeight, const bool kShuffle, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	for (uint32_t y = 0; y <= kSize; ++y)
+	{
+		for (uint32_t x = 0; x <= kSize; ++x)
+		{
+			const float kU = static_cast<float>(x) / static_cast<float>(kSize);
+			const float kV = static_cast<float>(y) / static_cast<float>(kSize);
+
+			Vertex vertex{};
+			vertex.pos = { static_cast<float>(x), kHeight * std::sin(kU * 3.1415926f) * std::sin(kV * 3.1415926f), static_cast<float>(y) };
+			vertex.uv = { kU, kV };
+			vertex.normal = { 0.f, 1.f, 0.f };
+			vertices.push_back(vertex);
+		}
+	}
+
+	std::vector<std::array<uint32_t, 3>> triangles;
+	for (uint32_t y = 0; y < kSize; ++y)
+	{
+		for (uint32_t x = 0; x < kSize; ++x)
+		{
+			const uint32_t kCorner = y * (kSize + 1) + x;
+			triangles.push_back({ kCorner, kCorner + kSize + 1, kCorner + 1 });
+			triangles.push_back({ kCorner + 1, kCorner + kSize + 1, kCorner + kSize + 2 });
+		}
+	}
+
+	if (kShuffle)
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+
+	for (const std::array<uint32_t, 3>& kTriangle : triangles)
+		indices.insert(indices.end(), kTriangle.begin(), kTriangle.end());
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+
+#include "Core.h"
+
+#include "VkRenderer/MemoryAllocator.h"
+
+namespace
+{
+	struct Range
+	{
+		uint32_t		_handle;
+		VkDeviceSize	_offset;
+		VkDeviceSize	_size;
+	};
+
+	void CheckRanges(std::vector<Range> ranges, const VkDeviceSize kSize)
+	{
+		std::sort(ranges.begin(), ranges.end(), [](const Range& kLhs, const Range& kRhs) { return kLhs._offset < kRhs._offset; });
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			ASSERT(ranges[i]._offset + ranges[i]._size <= kSize, "allocation is out of the allocator range")
+			if (i > 0)
+			{
+				ASSERT(ranges[i - 1]._offset + ranges[i - 1]._size <= ranges[i]._offset, "allocations overlap")
+			}
+		}
+	}
+}
+
+int main(int, char**)
+{
+	ez::LogSystem::_standardOutput = true;
+
+	constexpr VkDeviceSize kSize = 1 << 20;
+	TlsfAllocator allocator(kSize);
+
+	// Whole range, then nothing left
+	{
+		VkDeviceSize offset = 1;
+		const uint32_t kHandle = allocator.Allocate(kSize, 1, offset);
+		ASSERT(kHandle != TlsfAllocator::INVALID_HANDLE && offset == 0, "whole range allocation failed")
+
+		VkDeviceSize unused = 0;
+		const uint32_t kFullHandle = allocator.Allocate(1, 1, unused);
+		ASSERT(kFullHandle == TlsfAllocator::INVALID_HANDLE, "allocated in a full allocator")
+
+		allocator.Free(kHandle);
+		ASSERT(allocator.IsEmpty() && allocator.UsedSize() == 0, "allocator is not empty after free")
+	}
+
+	// Random sizes and alignments, freed in random order
+	std::mt19937 random(42);
+	std::uniform_int_distribution<uint32_t> sizeDistribution(1, 4096);
+	std::uniform_int_distribution<uint32_t> alignmentDistribution(0, 8);
+
+	std::vector<Range> ranges;
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		for (;;)
+		{
+			const VkDeviceSize kAllocationSize = sizeDistribution(random);
+			const VkDeviceSize kAlignment = 1ull << alignmentDistribution(random);
+
+			VkDeviceSize offset = 0;
+			const uint32_t kHandle = allocator.Allocate(kAllocationSize, kAlignment, offset);
+			if (kHandle == TlsfAllocator::INVALID_HANDLE)
+				break;
+
+			ASSERT(offset % kAlignment == 0, "allocation is not aligned")
+			ranges.push_back({ kHandle, offset, kAllocationSize });
+		}
+
+		CheckRanges(ranges, kSize);
+		ASSERT(allocator.AllocationCount() == ranges.size(), "wrong allocation count")
+		ASSERT(allocator.UsedSize() > kSize * 3 / 4, "allocator is full while mostly unused")
+
+		std::shuffle(ranges.begin(), ranges.end(), random);
+		const size_t kFreeCount = iteration == 7 ? ranges.size() : ranges.size() / 2;
+		for (size_t i = 0; i < kFreeCount; ++i)
+			allocator.Free(ranges[i]._handle);
+		ranges.erase(ranges.begin(), ranges.begin() + kFreeCount);
+	}
+
+	// Every free block merged back in a single range
+	ASSERT(allocator.IsEmpty() && allocator.UsedSize() == 0, "allocator is not empty after freeing everything")
+
+	VkDeviceSize offset = 1;
+	const uint32_t kMergedHandle = allocator.Allocate(kSize, 1, offset);
+	ASSERT(kMergedHandle != TlsfAllocator::INVALID_HANDLE && offset == 0, "free blocks were not merged")
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include <cstdlib>
+#include <algorithm>
+
+#include "Core.h"
+
+#include "Scene/MeshOptimizer.h"
+
+#include "Grid.h"
+
+namespace
+{
+	// Triangles as a sorted list of rotation independent keys, to check reorderings keep the same mesh
+	std::vector<std::array<Vec3, 3>> GetTriangles(const std::vector<Vertex>& kVertices, const std::vector<uint32_t>& kIndices)
+	{
+		std::vector<std::array<Vec3, 3>> triangles;
+		for (size_t i = 0; i < kIndices.size(); i += 3)
+		{
+			std::array<Vec3, 3> triangle{ kVertices[kIndices[i]].pos, kVertices[kIndices[i + 1]].pos, kVertices[kIndices[i + 2]].pos };
+
+			// Rotate so the smallest corner comes first, winding is kept
+			const auto kLess = [](const Vec3& kA, const Vec3& kB) { return std::tie(kA.x, kA.y, kA.z) < std::tie(kB.x, kB.y, kB.z); };
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end(), kLess), triangle.end());
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end(), [](const std::array<Vec3, 3>& kA, const std::array<Vec3, 3>& kB) {
+			for (size_t i = 0; i < 3; ++i)
+			{
+				if (kA[i] != kB[i])
+					return std::tie(kA[i].x, kA[i].y, kA[i].z) < std::tie(kB[i].x, kB[i].y, kB[i].z);
+			}
+			return false;
+		});
+
+		return triangles;
+	}
+}
+
+int main(int, char**)
+{
+	ez::LogSystem::_standardOutput = true;
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	CreateGrid(64, 0.f, true, vertices, indices);
+
+	const std::vector<std::array<Vec3, 3>> kTriangles = GetTriangles(vertices, indices);
+	const VertexCacheStatistics kBaseStatistics = AnalyzeVertexCache(indices, vertices.size());
+
+	// Vertex cache
+	OptimizeVertexCache(indices, vertices.size());
+	ASSERT(GetTriangles(vertices, indices) == kTriangles, "vertex cache optimization changed the triangles")
+
+	const VertexCacheStatistics kCacheStatistics = AnalyzeVertexCache(indices, vertices.size());
+	ASSERT(kCacheStatistics._acmr < kBaseStatistics._acmr * 0.5f, "vertex cache optimization did not improve ACMR")
+	ASSERT(kCacheStatistics._acmr < 1.f, "ACMR is too high for a regular grid")
+	ASSERT(kCacheStatistics._atvr >= 1.f, "ATVR can't be lower than 1")
+
+	// Overdraw
+	OptimizeOverdraw(indices, vertices, 1.05f);
+	ASSERT(GetTriangles(vertices, indices) == kTriangles, "overdraw optimization changed the triangles")
+
+	const VertexCacheStatistics kOverdrawStatistics = AnalyzeVertexCache(indices, vertices.size());
+	ASSERT(kOverdrawStatistics._acmr < kBaseStatistics._acmr * 0.5f, "overdraw optimization lost the vertex cache locality")
+
+	// Vertex fetch
+	OptimizeVertexFetch(vertices, indices);
+	ASSERT(GetTriangles(vertices, indices) == kTriangles, "vertex fetch optimization changed the triangles")
+
+	uint32_t nextVertex = 0;
+	for (const uint32_t kIndex : indices)
+	{
+		ASSERT(kIndex <= nextVertex, "vertices are not in fetch order")
+		if (kIndex == nextVertex)
+			nextVertex++;
+	}
+	ASSERT(nextVertex == vertices.size(), "vertex fetch optimization kept unused vertices")
+
+	const VertexCacheStatistics kFetchStatistics = AnalyzeVertexCache(indices, vertices.size());
+	ASSERT(kFetchStatistics._transformedVertices == kOverdrawStatistics._transformedVertices, "vertex fetch optimization changed the cache behaviour")
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#include <cstdlib>
+
+#include "Core.h"
+
+#include "Scene/MeshSimplifier.h"
+
+#include "Grid.h"
+
+namespace
+{
+	bool IsBorder(const Vec3& kPos, const float kSize)
+	{
+		return kPos.x == 0.f || kPos.z == 0.f || kPos.x == kSize || kPos.z == kSize;
+	}
+
+	void CheckSimplified(const std::vector<Vertex>& kVertices, const std::vector<uint32_t>& kSource, const std::vector<uint32_t>& kIndices, const float kSize)
+	{
+		ASSERT(kIndices.size() % 3 == 0, "simplified indices are not a triangle list")
+
+		std::vector<bool> sourceBorder(kVertices.size(), false);
+		for (const uint32_t kIndex : kSource)
+			sourceBorder[kIndex] = IsBorder(kVertices[kIndex].pos, kSize);
+
+		std::vector<bool> used(kVertices.size(), false);
+		for (size_t i = 0; i < kIndices.size(); i += 3)
+		{
+			ASSERT(kIndices[i] < kVertices.size() && kIndices[i + 1] < kVertices.size() && kIndices[i + 2] < kVertices.size(), "index out of range")
+			ASSERT(kIndices[i] != kIndices[i + 1] && kIndices[i + 1] != kIndices[i + 2] && kIndices[i + 2] != kIndices[i], "degenerate triangle")
+
+			const Vec3 kNormal = glm::cross(kVertices[kIndices[i + 1]].pos - kVertices[kIndices[i]].pos, kVertices[kIndices[i + 2]].pos - kVertices[kIndices[i]].pos);
+			ASSERT(kNormal.y > 0.f, "simplification flipped a triangle")
+
+			used[kIndices[i]] = used[kIndices[i + 1]] = used[kIndices[i + 2]] = true;
+		}
+
+		for (size_t i = 0; i < kVertices.size(); ++i)
+		{
+			ASSERT(!sourceBorder[i] || used[i], "simplification removed a border vertex")
+		}
+	}
+}
+
+int main(int, char**)
+{
+	ez::LogSystem::_standardOutput = true;
+
+	constexpr uint32_t kSize = 32;
+
+	// Flat grid, every inner vertex can go without any error
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		CreateGrid(kSize, 0.f, false, vertices, indices);
+
+		float error = -1.f;
+		const std::vector<uint32_t> kSimplified = SimplifyMesh(indices, vertices, indices.size() / 4, 1e-3f, &error);
+
+		CheckSimplified(vertices, indices, kSimplified, static_cast<float>(kSize));
+		ASSERT(kSimplified.size() <= indices.size() / 4, "flat grid was not simplified down to the target")
+		ASSERT(error >= 0.f && error < 1e-3f, "flat grid simplification reported an error")
+	}
+
+	// Bent grid, the error grows with the reduction and bounds it
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		CreateGrid(kSize, 4.f, false, vertices, indices);
+
+		float lowError = 0.f;
+		const std::vector<uint32_t> kHalf = SimplifyMesh(indices, vertices, indices.size() / 2, 1.f, &lowError);
+		CheckSimplified(vertices, indices, kHalf, static_cast<float>(kSize));
+		ASSERT(kHalf.size() <= indices.size() / 2, "bent grid was not simplified down to the target")
+
+		float highError = 0.f;
+		const std::vector<uint32_t> kQuarter = SimplifyMesh(kHalf, vertices, kHalf.size() / 4, 1.f, &highError);
+		CheckSimplified(vertices, indices, kQuarter, static_cast<float>(kSize));
+		ASSERT(kQuarter.size() < kHalf.size(), "bent grid was not simplified further")
+		ASSERT(highError >= lowError && highError <= 1.f, "simplification error is not bounded")
+
+		float boundedError = 0.f;
+		const std::vector<uint32_t> kBounded = SimplifyMesh(indices, vertices, 0, 1e-4f, &boundedError);
+		ASSERT(boundedError <= 1e-4f, "simplification went over the target error")
+		ASSERT(kBounded.size() > kQuarter.size(), "target error did not stop the simplification")
+	}
+
+	return EXIT_SUCCESS;
+}
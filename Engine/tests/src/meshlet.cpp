@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <algorithm>
+#include <array>
+
+#include "Core.h"
+
+#include "Scene/Meshlet.h"
+
+#include "Grid.h"
+
+int main(int, char**)
+{
+	ez::LogSystem::_standardOutput = true;
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	CreateGrid(32, 0.f, false, vertices, indices);
+
+	const MeshletData kData = BuildMeshlets(indices, vertices);
+	ASSERT(!kData._meshlets.empty(), "no meshlet built")
+	ASSERT(kData._triangles.size() == indices.size(), "meshlets don't cover every triangle")
+
+	// Limits, coverage and bounds
+	uint32_t triangleOffset = 0;
+	for (const Meshlet& kMeshlet : kData._meshlets)
+	{
+		ASSERT(kMeshlet._vertexCount <= MESHLET_MAX_VERTICES, "meshlet has too many vertices")
+		ASSERT(kMeshlet._triangleCount <= MESHLET_MAX_TRIANGLES, "meshlet has too many triangles")
+		ASSERT(kMeshlet._triangleOffset == triangleOffset, "meshlets are not contiguous ranges of the indices")
+
+		for (uint32_t i = 0; i < kMeshlet._triangleCount * 3; ++i)
+		{
+			const uint8_t kLocalIndex = kData._triangles[kMeshlet._triangleOffset * 3 + i];
+			ASSERT(kLocalIndex < kMeshlet._vertexCount, "meshlet triangle uses an unknown vertex")
+
+			const uint32_t kIndex = kData._vertices[kMeshlet._vertexOffset + kLocalIndex];
+			ASSERT(kIndex == indices[kMeshlet._triangleOffset * 3 + i], "meshlet triangle doesn't match the mesh")
+			ASSERT(glm::distance(vertices[kIndex].pos, kMeshlet._center) <= kMeshlet._radius * 1.0001f, "vertex outside the meshlet sphere")
+		}
+
+		triangleOffset += kMeshlet._triangleCount;
+	}
+
+	// Cone culling, a flat meshlet is only seen from above
+	for (const Meshlet& kMeshlet : kData._meshlets)
+	{
+		ASSERT(kMeshlet._coneAxis.y > 0.99f, "cone axis is not the grid normal")
+		ASSERT(!IsMeshletBackfacing(kMeshlet, kMeshlet._center + Vec3(0.f, 10.f, 0.f)), "meshlet seen from the front is culled")
+		ASSERT(IsMeshletBackfacing(kMeshlet, kMeshlet._center + Vec3(3.f, -10.f, 0.f)), "meshlet seen from the back is not culled")
+	}
+
+	// Frustum culling, with an identity matrix the frustum is the clip space box
+	const Frustum kFrustum = ExtractFrustum(Mat4(1.f));
+
+	Meshlet meshlet{};
+	meshlet._radius = 0.25f;
+
+	meshlet._center = { 0.f, 0.f, 0.5f };
+	ASSERT(IsMeshletInFrustum(meshlet, kFrustum), "meshlet inside the frustum is culled")
+
+	meshlet._center = { 1.1f, 0.f, 0.5f };
+	ASSERT(IsMeshletInFrustum(meshlet, kFrustum), "meshlet crossing the frustum is culled")
+
+	meshlet._center = { 2.f, 0.f, 0.5f };
+	ASSERT(!IsMeshletInFrustum(meshlet, kFrustum), "meshlet right of the frustum is not culled")
+
+	meshlet._center = { 0.f, 0.f, -1.f };
+	ASSERT(!IsMeshletInFrustum(meshlet, kFrustum), "meshlet behind the near plane is not culled")
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+
+#include "Core.h"
+
+#include "Scene/RenderQueue.h"
+
+int main(int, char**)
+{
+	ez::LogSystem::_standardOutput = true;
+
+	using Pass = RenderQueue::Pass;
+
+	// Opaque: state first, then front to back
+	ASSERT(RenderQueue::MakeKey(Pass::OPAQUE, 0, 0, 0, 1.f) < RenderQueue::MakeKey(Pass::OPAQUE, 0, 0, 0, 5.f), "opaque draws are not front to back")
+	ASSERT(RenderQueue::MakeKey(Pass::OPAQUE, 0, 3, 7, 100.f) < RenderQueue::MakeKey(Pass::OPAQUE, 1, 0, 0, 1.f), "pipeline doesn't come before depth")
+	ASSERT(RenderQueue::MakeKey(Pass::OPAQUE, 2, 0, 7, 100.f) < RenderQueue::MakeKey(Pass::OPAQUE, 2, 1, 0, 1.f), "material doesn't come before mesh")
+	ASSERT(RenderQueue::MakeKey(Pass::OPAQUE, 0, 0, 0, -3.f) == RenderQueue::MakeKey(Pass::OPAQUE, 0, 0, 0, 0.f), "negative depth is not clamped")
+
+	// Transparent: after every opaque draw, back to front whatever the state
+	ASSERT(RenderQueue::MakeKey(Pass::OPAQUE, 4095, 16383, 4095, 1e30f) < RenderQueue::MakeKey(Pass::TRANSPARENT, 0, 0, 0, 0.f), "transparent draws are not last")
+	ASSERT(RenderQueue::MakeKey(Pass::TRANSPARENT, 1, 0, 0, 5.f) < RenderQueue::MakeKey(Pass::TRANSPARENT, 0, 0, 0, 1.f), "transparent draws are not back to front")
+
+	// Sort matches a stable sort on random keys, duplicated to check stability
+	std::mt19937_64 random(42);
+	RenderQueue queue;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		RenderQueue::Packet packet;
+		packet._key = (i % 3 == 0) ? (random() & 0xFFFF00000000FFFFull) : queue._packets.back()._key;
+		packet._lod = i;
+		queue._packets.push_back(packet);
+	}
+
+	std::vector<RenderQueue::Packet> expected = queue._packets;
+	std::stable_sort(expected.begin(), expected.end(),
+		[](const RenderQueue::Packet& kA, const RenderQueue::Packet& kB) { return kA._key < kB._key; });
+
+	queue.Sort();
+	ASSERT(queue._packets.size() == expected.size(), "packets lost by Sort")
+	for (size_t i = 0; i < expected.size(); ++i)
+	{
+		ASSERT(queue._packets[i]._key == expected[i]._key && queue._packets[i]._lod == expected[i]._lod, "packet " + std::to_string(i) + " is out of order")
+	}
+
+	// Every key equal, nothing moves
+	RenderQueue same;
+	for (size_t i = 0; i < 16; ++i)
+		same._packets.push_back({ 7, nullptr, i });
+	same.Sort();
+	for (size_t i = 0; i < same._packets.size(); ++i)
+	{
+		ASSERT(same._packets[i]._lod == i, "equal keys are reordered")
+	}
+
+	return EXIT_SUCCESS;
+}
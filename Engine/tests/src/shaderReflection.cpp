@@ -0,0 +1,256 @@
+#include <cstdlib>
+#include <initializer_list>
+
+#include "Core.h"
+
+#include "VkRenderer/ShaderReflection.h"
+
+namespace
+{
+	// Just enough of a SPIR-V assembler to describe the interface of a shader
+	class Module
+	{
+		std::vector<uint32_t>	_code{ 0x07230203, 0x00010000, 0, 1, 0 };
+
+	public:
+		uint32_t Id()
+		{
+			return _code[3]++;
+		}
+
+		void Op(const uint16_t kOpcode, std::initializer_list<uint32_t> operands)
+		{
+			_code.push_back(static_cast<uint32_t>(operands.size() + 1) << 16 | kOpcode);
+			_code.insert(_code.end(), operands.begin(), operands.end());
+		}
+
+		const std::vector<uint32_t>& Code() const
+		{
+			return _code;
+		}
+	};
+
+	enum Op : uint16_t
+	{
+		OP_ENTRY_POINT		= 15,
+		OP_TYPE_VOID		= 19,
+		OP_TYPE_INT			= 21,
+		OP_TYPE_FLOAT		= 22,
+		OP_TYPE_VECTOR		= 23,
+		OP_TYPE_MATRIX		= 24,
+		OP_TYPE_IMAGE		= 25,
+		OP_TYPE_SAMPLED_IMAGE	= 27,
+		OP_TYPE_ARRAY		= 28,
+		OP_TYPE_STRUCT		= 30,
+		OP_TYPE_POINTER		= 32,
+		OP_TYPE_FUNCTION	= 33,
+		OP_CONSTANT			= 43,
+		OP_FUNCTION			= 54,
+		OP_FUNCTION_END		= 56,
+		OP_VARIABLE			= 59,
+		OP_LOAD				= 61,
+		OP_DECORATE			= 71,
+		OP_MEMBER_DECORATE	= 72,
+		OP_LABEL			= 248,
+		OP_RETURN			= 253
+	};
+
+	constexpr uint32_t MAIN = 0x6E69616D;
+
+	struct Types
+	{
+		uint32_t _void, _function, _int, _uint, _float, _vec2, _vec3, _vec4, _mat4, _sampledImage, _four;
+	};
+
+	Types DeclareTypes(Module& module)
+	{
+		Types types;
+		types._void = module.Id();
+		types._function = module.Id();
+		types._int = module.Id();
+		types._uint = module.Id();
+		types._float = module.Id();
+		types._vec2 = module.Id();
+		types._vec3 = module.Id();
+		types._vec4 = module.Id();
+		types._mat4 = module.Id();
+		const uint32_t kImage = module.Id();
+		types._sampledImage = module.Id();
+		types._four = module.Id();
+
+		module.Op(OP_TYPE_VOID, { types._void });
+		module.Op(OP_TYPE_FUNCTION, { types._function, types._void });
+		module.Op(OP_TYPE_INT, { types._int, 32, 1 });
+		module.Op(OP_TYPE_INT, { types._uint, 32, 0 });
+		module.Op(OP_TYPE_FLOAT, { types._float, 32 });
+		module.Op(OP_TYPE_VECTOR, { types._vec2, types._float, 2 });
+		module.Op(OP_TYPE_VECTOR, { types._vec3, types._float, 3 });
+		module.Op(OP_TYPE_VECTOR, { types._vec4, types._float, 4 });
+		module.Op(OP_TYPE_MATRIX, { types._mat4, types._vec4, 4 });
+		module.Op(OP_TYPE_IMAGE, { kImage, types._float, 1, 0, 0, 0, 1, 0 });
+		module.Op(OP_TYPE_SAMPLED_IMAGE, { types._sampledImage, kImage });
+		module.Op(OP_CONSTANT, { types._uint, types._four, 4 });
+
+		return types;
+	}
+
+	uint32_t Variable(Module& module, const uint32_t kType, const uint32_t kStorageClass)
+	{
+		const uint32_t kPointer = module.Id();
+		const uint32_t kVariable = module.Id();
+		module.Op(OP_TYPE_POINTER, { kPointer, kStorageClass, kType });
+		module.Op(OP_VARIABLE, { kPointer, kVariable, kStorageClass });
+		return kVariable;
+	}
+
+	void Resource(Module& module, const uint32_t kVariable, const uint32_t kSet, const uint32_t kBinding)
+	{
+		module.Op(OP_DECORATE, { kVariable, 34, kSet });
+		module.Op(OP_DECORATE, { kVariable, 33, kBinding });
+	}
+
+	void Main(Module& module, const Types& kTypes, const uint32_t kMain, std::initializer_list<uint32_t> used)
+	{
+		module.Op(OP_FUNCTION, { kTypes._void, kMain, 0, kTypes._function });
+		module.Op(OP_LABEL, { module.Id() });
+		for (const uint32_t kVariable : used)
+			module.Op(OP_LOAD, { kTypes._float, module.Id(), kVariable });
+		module.Op(OP_RETURN, {});
+		module.Op(OP_FUNCTION_END, {});
+	}
+
+	// Camera block, an unused array of 4 samplers, a push constant matrix and two vertex inputs
+	std::vector<uint32_t> VertexShader()
+	{
+		Module module;
+		const uint32_t kMain = module.Id();
+		module.Op(OP_ENTRY_POINT, { 0, kMain, MAIN, 0 });
+
+		const Types kTypes = DeclareTypes(module);
+
+		const uint32_t kCamera = module.Id();
+		module.Op(OP_TYPE_STRUCT, { kCamera, kTypes._mat4, kTypes._mat4, kTypes._vec3 });
+		module.Op(OP_MEMBER_DECORATE, { kCamera, 0, 35, 0 });
+		module.Op(OP_MEMBER_DECORATE, { kCamera, 0, 7, 16 });
+		module.Op(OP_MEMBER_DECORATE, { kCamera, 1, 35, 64 });
+		module.Op(OP_MEMBER_DECORATE, { kCamera, 1, 7, 16 });
+		module.Op(OP_MEMBER_DECORATE, { kCamera, 2, 35, 128 });
+		const uint32_t kCameraVariable = Variable(module, kCamera, 2);
+		Resource(module, kCameraVariable, 0, 0);
+
+		const uint32_t kSamplers = module.Id();
+		module.Op(OP_TYPE_ARRAY, { kSamplers, kTypes._sampledImage, kTypes._four });
+		Resource(module, Variable(module, kSamplers, 0), 1, 3);
+
+		const uint32_t kPush = module.Id();
+		module.Op(OP_TYPE_STRUCT, { kPush, kTypes._mat4 });
+		module.Op(OP_MEMBER_DECORATE, { kPush, 0, 35, 0 });
+		module.Op(OP_MEMBER_DECORATE, { kPush, 0, 7, 16 });
+		const uint32_t kPushVariable = Variable(module, kPush, 9);
+
+		const uint32_t kPosition = Variable(module, kTypes._vec3, 1);
+		module.Op(OP_DECORATE, { kPosition, 30, 0 });
+		const uint32_t kUV = Variable(module, kTypes._vec2, 1);
+		module.Op(OP_DECORATE, { kUV, 30, 1 });
+		const uint32_t kVertexIndex = Variable(module, kTypes._int, 1);
+		module.Op(OP_DECORATE, { kVertexIndex, 11, 42 });
+
+		Main(module, kTypes, kMain, { kCameraVariable, kPushVariable, kPosition, kUV, kVertexIndex });
+		return module.Code();
+	}
+
+	// Light block, the samplers shared with the vertex shader and a push constant after the matrix
+	std::vector<uint32_t> FragmentShader()
+	{
+		Module module;
+		const uint32_t kMain = module.Id();
+		module.Op(OP_ENTRY_POINT, { 4, kMain, MAIN, 0 });
+
+		const Types kTypes = DeclareTypes(module);
+
+		const uint32_t kLight = module.Id();
+		module.Op(OP_TYPE_STRUCT, { kLight, kTypes._vec3, kTypes._float });
+		module.Op(OP_MEMBER_DECORATE, { kLight, 0, 35, 0 });
+		module.Op(OP_MEMBER_DECORATE, { kLight, 1, 35, 12 });
+		const uint32_t kLightVariable = Variable(module, kLight, 2);
+		Resource(module, kLightVariable, 0, 1);
+
+		const uint32_t kSamplers = module.Id();
+		module.Op(OP_TYPE_ARRAY, { kSamplers, kTypes._sampledImage, kTypes._four });
+		const uint32_t kSamplersVariable = Variable(module, kSamplers, 0);
+		Resource(module, kSamplersVariable, 1, 3);
+
+		const uint32_t kPush = module.Id();
+		module.Op(OP_TYPE_STRUCT, { kPush, kTypes._vec4 });
+		module.Op(OP_MEMBER_DECORATE, { kPush, 0, 35, 64 });
+		const uint32_t kPushVariable = Variable(module, kPush, 9);
+
+		const uint32_t kInput = Variable(module, kTypes._vec3, 1);
+		module.Op(OP_DECORATE, { kInput, 30, 0 });
+
+		Main(module, kTypes, kMain, { kLightVariable, kSamplersVariable, kPushVariable, kInput });
+		return module.Code();
+	}
+}
+
+int main(int, char**)
+{
+	ez::LogSystem::_standardOutput = true;
+
+	const std::vector<uint32_t> kVertexCode = VertexShader();
+	const std::vector<uint32_t> kFragmentCode = FragmentShader();
+
+	const ShaderReflection kVertex = ShaderReflection::Reflect(kVertexCode);
+	const ShaderReflection kFragment = ShaderReflection::Reflect(kFragmentCode);
+
+	// Vertex stage alone
+	{
+		ASSERT(kVertex._stage == VK_SHADER_STAGE_VERTEX_BIT, "vertex stage is wrong")
+		ASSERT(kVertex._bindings.size() == 2, "vertex bindings count is wrong")
+
+		const ShaderReflection::Binding* kCamera = kVertex.FindBinding(0, 0);
+		ASSERT(kCamera != nullptr && kCamera->_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, "camera block is not reflected")
+		ASSERT(kCamera->_size == 140 && kCamera->_count == 1, "camera block size is wrong")
+		ASSERT(kCamera->_stages == VK_SHADER_STAGE_VERTEX_BIT, "camera block stages are wrong")
+
+		const ShaderReflection::Binding* kSamplers = kVertex.FindBinding(1, 3);
+		ASSERT(kSamplers != nullptr && kSamplers->_type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, "samplers are not reflected")
+		ASSERT(kSamplers->_count == 4, "samplers count is wrong")
+		ASSERT(kSamplers->_stages == 0, "declared only samplers are counted as accessed")
+
+		ASSERT(kVertex._pushConstant.offset == 0 && kVertex._pushConstant.size == 64, "vertex push constant is wrong")
+
+		ASSERT(kVertex._inputs.size() == 2, "built-in is counted as a vertex input")
+		ASSERT(kVertex._inputs[0]._location == 0 && kVertex._inputs[0]._format == VK_FORMAT_R32G32B32_SFLOAT, "position input is wrong")
+		ASSERT(kVertex._inputs[1]._location == 1 && kVertex._inputs[1]._format == VK_FORMAT_R32G32_SFLOAT, "uv input is wrong")
+	}
+
+	// Stages merged into the pipeline layout
+	{
+		const ShaderReflection* kStages[] = { &kVertex, &kFragment };
+		const ShaderReflection kMerged = ShaderReflection::Merge(kStages);
+
+		ASSERT(kMerged._stage == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), "merged stages are wrong")
+		ASSERT(kMerged._bindings.size() == 3 && kMerged.SetCount() == 2, "merged bindings count is wrong")
+
+		ASSERT(kMerged._bindings[0]._binding == 0 && kMerged._bindings[0]._stages == VK_SHADER_STAGE_VERTEX_BIT, "camera block is not sorted first")
+		ASSERT(kMerged._bindings[1]._binding == 1 && kMerged._bindings[1]._stages == VK_SHADER_STAGE_FRAGMENT_BIT, "light block is not sorted second")
+		ASSERT(kMerged._bindings[1]._size == 16, "light block size is wrong")
+		ASSERT(kMerged._bindings[2]._set == 1 && kMerged._bindings[2]._stages == VK_SHADER_STAGE_FRAGMENT_BIT, "samplers don't only show in the stage accessing them")
+
+		ASSERT(kMerged._pushConstant.offset == 0 && kMerged._pushConstant.size == 80, "merged push constant range is wrong")
+		ASSERT(kMerged._pushConstant.stageFlags == (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), "merged push constant stages are wrong")
+
+		ASSERT(kMerged._inputs.size() == 2, "vertex inputs are not kept")
+	}
+
+	// Declared but accessed by no stage, it still has to be in the layout
+	{
+		const ShaderReflection* kStages[] = { &kVertex };
+		const ShaderReflection kMerged = ShaderReflection::Merge(kStages);
+
+		ASSERT(kMerged.FindBinding(1, 3)->_stages == VK_SHADER_STAGE_VERTEX_BIT, "unused binding has no stage")
+	}
+
+	return EXIT_SUCCESS;
+}
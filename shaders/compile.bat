@@ -1,5 +1,7 @@
 glslc.exe shader.vert -o bin/shader.vert.spv
+glslc.exe shader_compact.vert -o bin/shader_compact.vert.spv
 glslc.exe shader.frag -o bin/shader.frag.spv
+glslc.exe shader_bindless.frag -o bin/shader_bindless.frag.spv
 
 glslc.exe skybox.vert -o bin/skybox.vert.spv
 glslc.exe skybox.frag -o bin/skybox.frag.spv
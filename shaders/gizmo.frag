@@ -1,13 +1,14 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(set = 1, binding = 1) uniform GizmoData {
-	vec3 _color;
+// The parameters of DrawConstants, after the model matrix
+layout(push_constant) uniform DrawData {
+	layout(offset = 64) vec4 _color;
 } gizmo;
 
 layout(location = 0) out vec4 outColor;
 
 void main() 
 {
-	outColor = vec4(gizmo._color, 1.0);
+	outColor = vec4(gizmo._color.rgb, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+// PBR shading shared by the material fragment shaders, included after their texture fetch functions:
+// vec3 sampleAlbedo(vec2 uv), float sampleMetallic(vec2 uv), vec3 sampleNormalMap(vec2 uv), float sampleRoughness(vec2 uv),
+// float sampleAO(vec2 uv), vec3 sampleSkybox(vec3 dir, float lod), vec3 sampleIrradiance(vec3 dir), vec2 sampleBRDF(vec2 uv)
+
+layout(set = 0, binding = 1) uniform LightData {
+	vec3 _pos;
+	float _intensity;
+	vec3 _color;
+	float _range;
+} light;
+
+layout(location = 0) in vec3 fragPos;
+layout(location = 1) in vec2 fragUV;
+layout(location = 2) in vec3 fragNormal;
+layout(location = 3) in vec3 fragTangent;
+layout(location = 4) in vec3 fragCamPos;
+
+layout(location = 0) out vec4 outColor;
+
+// Variants of the material, the disabled paths are compiled out
+layout(constant_id = 0) const bool USE_NORMAL_MAP = true;
+layout(constant_id = 1) const bool USE_ROUGHNESS_MAP = true;
+layout(constant_id = 2) const float CONSTANT_ROUGHNESS = 0.5;
+layout(constant_id = 3) const bool USE_IBL = true;
+
+const float PI = 3.14159265359;
+
+vec3 getNormalFromNormalMapping()
+{
+	vec3 T = normalize(fragTangent);
+	vec3 N = normalize(fragNormal);
+	// re-orthogonalize T with respect to N
+	T = normalize(T - dot(T, N) * N);
+	// then retrieve perpendicular vector B with the cross product of T and N
+	vec3 B = cross(N, T);
+
+	mat3 TBN = mat3(T, B, N);
+	return normalize(TBN * (sampleNormalMap(fragUV) * 2.0 - 1.0)); 
+}
+
+vec3 Fresnel(vec3 f0, float cosTheta, float roughness)
+{
+	return f0 + (max(vec3(1.0 - roughness), f0) - f0) * pow(1.0 - cosTheta, 5.0);
+}  
+
+float DistributionGGX(float cosAlpha, float roughness)
+{
+	float roughSqr = roughness * roughness;
+
+	float denom = cosAlpha * cosAlpha * (roughSqr - 1.0) + 1.0;
+
+    return roughSqr / (PI * denom * denom);
+}
+
+float GeometrySchlickGGX(float cosRho, float roughness)
+{
+	float k = ((roughness + 1.0) * (roughness + 1.0)) / 8.0;
+
+    return cosRho / (cosRho * (1.0 - k) + k);
+}
+
+float GeometrySmith(float cosTheta, float cosRho, float roughness)
+{
+	float ggx1 = GeometrySchlickGGX(cosRho, roughness);
+    float ggx2 = GeometrySchlickGGX(cosTheta, roughness);
+	
+    return ggx1 * ggx2;
+}
+
+float ComputeAttenuation(vec3 lightPosition, float lightRange)
+{
+	float distance = length(lightPosition - fragPos);
+
+	return max(1 - (distance / lightRange), 0.0);
+}
+
+vec3 pbrShading()
+{
+	vec3 albedo     = sampleAlbedo(fragUV);
+    vec3 normal     = USE_NORMAL_MAP ? getNormalFromNormalMapping() : normalize(fragNormal);
+    float metallic  = sampleMetallic(fragUV);
+    float roughness = USE_ROUGHNESS_MAP ? sampleRoughness(fragUV) : CONSTANT_ROUGHNESS;
+    float ao        = sampleAO(fragUV);
+
+	vec3 lightV = normalize(light._pos - fragPos);
+	vec3 camV = normalize(fragCamPos - fragPos);
+
+	vec3 f0 = mix(vec3(0.16), albedo, metallic);
+
+	// AMBIENT
+	vec3 ambient = light._color  * albedo;
+
+	// BRDF
+	float cosTheta = dot(normal, lightV);
+	vec3 BRDF = vec3(0.0);
+
+	if(cosTheta > 0.0)
+	{
+		vec3 halfV = normalize(lightV + camV);
+		vec3 F = Fresnel(f0, dot(camV, halfV), roughness);
+
+		// DIFFUSE
+		vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+		vec3 diffuse = (kD * light._color * albedo) / PI;
+
+		// SPECULAR
+		float cosAlpha = dot(normal, halfV);
+		float cosRho = dot(normal, camV);
+
+		vec3 specular = vec3(0);
+		if(cosAlpha > 0.0 && cosRho > 0.0)
+		{
+			float NDF = DistributionGGX(cosAlpha, roughness);
+			float G = GeometrySmith(cosTheta, cosRho, roughness);
+		
+			specular = light._color * (NDF * G * F) / (4.0 * cosTheta * cosRho);
+		}
+
+		BRDF = (diffuse + specular) * cosTheta;
+	}
+
+	vec3 lighting = (ambient + BRDF) * ComputeAttenuation(light._pos, light._range) * light._intensity;
+	if (!USE_IBL)
+		return lighting;
+
+	// IBL
+	float cosAlpha = max(dot(camV, normal), 0.0);
+
+	vec3 kS = Fresnel(f0, cosAlpha, roughness);
+
+	vec3 refl = reflect(-camV, normal);
+	vec3 prefilteredColor = sampleSkybox(refl, roughness);
+	vec2 envBRDF  = sampleBRDF(vec2(cosAlpha, roughness));
+	vec3 specular = prefilteredColor * (kS * envBRDF.x + envBRDF.y);
+
+	// DIFFUSE
+	vec3 irradiance = sampleIrradiance(normal);
+
+	vec3 kD = (1.0 - kS) * (1.0 - metallic);
+	vec3 diffuse = kD * irradiance * albedo;
+
+	vec3 ibl = (diffuse + specular) * ao;
+
+	return lighting + ibl;
+}
+
+void main() 
+{
+	outColor = vec4(pbrShading(), 1.0);
+}
\ No newline at end of file
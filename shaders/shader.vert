@@ -7,7 +7,8 @@ layout(set = 0, binding = 0) uniform Camera {
 	vec3 _pos;
 } cam;
 
-layout(set = 2, binding = 0) uniform ModelData {
+// Pushed with every draw, see DrawConstants
+layout(push_constant) uniform DrawData {
     mat4 _model;
 } model;
 
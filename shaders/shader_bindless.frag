@@ -0,0 +1,47 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+
+// BindlessRegistry, every texture of the scene in two arrays
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(set = 1, binding = 1) uniform samplerCube cubemaps[];
+
+struct MaterialData {
+	uint _textures[8];
+};
+
+layout(set = 1, binding = 2, std430) readonly buffer Materials {
+	MaterialData _data[];
+} materials;
+
+layout(push_constant) uniform DrawConstants {
+	layout(offset = 80) uint _materialIndex;
+} constants;
+
+// Slots of MaterialData::_textures, the environment is read through the material too
+const uint ALBEDO_MAP = 0;
+const uint METALLIC_MAP = 1;
+const uint NORMAL_MAP = 2;
+const uint ROUGHNESS_MAP = 3;
+const uint AO_MAP = 4;
+const uint SKYBOX_CUBEMAP = 5;
+const uint IRRADIANCE_CUBEMAP = 6;
+const uint BRDF_LOOKUP_TABLE = 7;
+
+// The index comes from a push constant, it is the same for the whole draw
+uint textureIndex(uint slot)
+{
+	return materials._data[constants._materialIndex]._textures[slot];
+}
+
+vec3 sampleAlbedo(vec2 uv)						{ return texture(textures[textureIndex(ALBEDO_MAP)], uv).rgb; }
+float sampleMetallic(vec2 uv)					{ return texture(textures[textureIndex(METALLIC_MAP)], uv).r; }
+vec3 sampleNormalMap(vec2 uv)					{ return texture(textures[textureIndex(NORMAL_MAP)], uv).rgb; }
+float sampleRoughness(vec2 uv)					{ return texture(textures[textureIndex(ROUGHNESS_MAP)], uv).r; }
+float sampleAO(vec2 uv)							{ return texture(textures[textureIndex(AO_MAP)], uv).r; }
+vec3 sampleSkybox(vec3 dir, float lod)			{ return textureLod(cubemaps[textureIndex(SKYBOX_CUBEMAP)], dir, lod).rgb; }
+vec3 sampleIrradiance(vec3 dir)					{ return texture(cubemaps[textureIndex(IRRADIANCE_CUBEMAP)], dir).xyz; }
+vec2 sampleBRDF(vec2 uv)						{ return texture(textures[textureIndex(BRDF_LOOKUP_TABLE)], uv).rg; }
+
+#include "pbr.glsl"
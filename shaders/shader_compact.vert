@@ -0,0 +1,47 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(set = 0, binding = 0) uniform Camera {
+    mat4 _view;
+    mat4 _proj;
+	vec3 _pos;
+} cam;
+
+// Pushed with every draw, see DrawConstants
+layout(push_constant) uniform DrawData {
+    mat4 _model;
+} model;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec2 inNormal;	// octahedral
+layout(location = 3) in vec2 inTangent;	// octahedral
+
+layout(location = 0) out vec3 fragPos;
+layout(location = 1) out vec2 fragUV;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 fragTangent;
+layout(location = 4) out vec3 fragCamPos;
+
+vec3 OctDecode(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(v);
+}
+
+void main() 
+{
+	vec4 modelPos = model._model * vec4(inPosition, 1.0);
+	fragPos = modelPos.xyz / modelPos.w;
+	fragUV = inUV;
+
+    gl_Position = cam._proj * cam._view * modelPos;
+
+	mat3 mNormal = transpose(inverse(mat3(model._model)));
+	fragNormal = mNormal * OctDecode(inNormal);
+    fragTangent = mNormal * OctDecode(inTangent);
+	
+	fragCamPos = cam._pos;
+}
\ No newline at end of file